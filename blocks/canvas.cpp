@@ -0,0 +1,110 @@
+#include "canvas.h"
+
+#include <array>
+
+namespace blocks {
+
+namespace {
+
+constexpr int kMaxCell = 6;
+
+constexpr std::array<uint32_t, 4> kHalfGlyphs = {' ', 0x2580, 0x2584, 0x2588};
+
+constexpr std::array<uint32_t, 16> kQuadrantGlyphs = {
+    ' ', 0x2598, 0x259D, 0x2580, 0x2596, 0x258C, 0x259E, 0x259B,
+    0x2597, 0x259A, 0x2590, 0x259C, 0x2584, 0x2599, 0x259F, 0x2588,
+};
+
+// The sextant block skips the patterns that already exist as half blocks.
+uint32_t SextantGlyph(uint8_t mask) {
+    constexpr uint8_t kLeft = 0b010101;
+    constexpr uint8_t kRight = 0b101010;
+    switch (mask) {
+        case 0:
+            return ' ';
+        case kLeft:
+            return 0x258C;
+        case kRight:
+            return 0x2590;
+        case kLeft | kRight:
+            return 0x2588;
+    }
+    return 0x1FB00 + mask - 1 - (mask > kLeft) - (mask > kRight);
+}
+
+}  // namespace
+
+int CellWidth(Layout layout) {
+    return layout == Layout::kHalf ? 1 : 2;
+}
+
+int CellHeight(Layout layout) {
+    return layout == Layout::kSextant ? 3 : 2;
+}
+
+uint32_t Glyph(Layout layout, uint8_t mask) {
+    switch (layout) {
+        case Layout::kHalf:
+            assert(mask < kHalfGlyphs.size());
+            return kHalfGlyphs[mask];
+        case Layout::kQuadrant:
+            assert(mask < kQuadrantGlyphs.size());
+            return kQuadrantGlyphs[mask];
+        case Layout::kSextant:
+            assert(mask < 64);
+            return SextantGlyph(mask);
+    }
+    assert(false);
+    return ' ';
+}
+
+tui::Object::Rectangle Canvas::BuildChars(std::pmr::memory_resource* resource) const {
+    int cell_w = CellWidth(layout_);
+    int cell_h = CellHeight(layout_);
+    int size = cell_w * cell_h;
+    assert(size <= kMaxCell);
+
+    auto result = Blank(resource);
+    std::array<tui::Color, kMaxCell> cell;
+    for (int i = 0; i < h_; ++i) {
+        for (int j = 0; j < w_; ++j) {
+            for (int k = 0; k < size; ++k) {
+                cell[k] = pixels_[(i * cell_h + k / cell_w) * pixel_w_ + j * cell_w + k % cell_w];
+            }
+            auto count = [&](tui::Color color) {
+                int result = 0;
+                for (int k = 0; k < size; ++k) {
+                    result += cell[k] == color;
+                }
+                return result;
+            };
+
+            // Empty sub-pixels can only become the background.
+            auto fg = tui::Color::kDefault;
+            int fg_count = 0;
+            for (int k = 0; k < size; ++k) {
+                if (cell[k] != tui::Color::kDefault && count(cell[k]) > fg_count) {
+                    fg = cell[k];
+                    fg_count = count(cell[k]);
+                }
+            }
+            auto bg = tui::Color::kDefault;
+            int bg_count = 0;
+            for (int k = 0; k < size; ++k) {
+                if (cell[k] != fg && count(cell[k]) > bg_count) {
+                    bg = cell[k];
+                    bg_count = count(cell[k]);
+                }
+            }
+
+            uint8_t mask = 0;
+            for (int k = 0; k < size; ++k) {
+                mask |= (fg_count > 0 && cell[k] == fg) << k;
+            }
+            result[i][j] = {.unicode = Glyph(layout_, mask), .fg = fg, .bg = bg};
+        }
+    }
+    return result;
+}
+
+}  // namespace blocks
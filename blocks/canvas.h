@@ -0,0 +1,90 @@
+#pragma once
+
+#include "tui/char.h"
+#include "tui/color.h"
+#include "tui/object.h"
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace blocks {
+
+// Block glyph family splitting a cell into a grid of sub-pixels. A cell
+// shows at most two colors, the glyph's foreground and its background.
+enum class Layout {
+    // 1x2, upper and lower half blocks.
+    kHalf,
+    // 2x2 quadrant blocks.
+    kQuadrant,
+    // 2x3 sextants from Unicode 13, need a recent terminal font.
+    kSextant,
+};
+
+int CellWidth(Layout layout);
+int CellHeight(Layout layout);
+
+// Glyph with the sub-pixels in `mask` drawn in the foreground color. Bit
+// `CellWidth() * row + column` stands for the sub-pixel at (row, column).
+uint32_t Glyph(Layout layout, uint8_t mask);
+
+class Canvas : public tui::Object {
+public:
+    // `h` and `w` are in sub-pixels.
+    Canvas(Layout layout, int h, int w)
+        : Object(h / CellHeight(layout), w / CellWidth(layout))
+        , layout_(layout)
+        , pixel_w_(w)
+        , pixels_(h * w, tui::Color::kDefault)
+    {
+        assert(h % CellHeight(layout) == 0);
+        assert(w % CellWidth(layout) == 0);
+    }
+
+    // Same as constructing anew, but keeps the storage when it is big enough.
+    void Resize(int h, int w) {
+        assert(h % CellHeight(layout_) == 0);
+        assert(w % CellWidth(layout_) == 0);
+
+        h_ = h / CellHeight(layout_);
+        w_ = w / CellWidth(layout_);
+        pixel_w_ = w;
+        pixels_.assign(h * w, tui::Color::kDefault);
+    }
+
+    Layout GetLayout() const {
+        return layout_;
+    }
+
+    int PixelHeight() const {
+        return h_ * CellHeight(layout_);
+    }
+
+    int PixelWidth() const {
+        return pixel_w_;
+    }
+
+    // `tui::Color::kDefault` leaves the sub-pixel empty.
+    void Set(int y, int x, tui::Color color) {
+        assert(y >= 0 && y < PixelHeight() && x >= 0 && x < pixel_w_);
+        pixels_[y * pixel_w_ + x] = color;
+    }
+
+    // Raw row of sub-pixels for bulk writers, `PixelWidth()` entries.
+    tui::Color* Row(int y) {
+        assert(y >= 0 && y < PixelHeight());
+        return pixels_.data() + y * pixel_w_;
+    }
+
+    // Every cell takes its most frequent color as the foreground and the
+    // next one as the background, sub-pixels of any other color fall back
+    // to the background.
+    tui::Object::Rectangle BuildChars(std::pmr::memory_resource* resource) const override;
+
+private:
+    Layout layout_;
+    int pixel_w_;
+    std::vector<tui::Color> pixels_;
+};
+
+}  // namespace blocks
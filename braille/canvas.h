@@ -16,38 +16,55 @@ public:
         assert(h % 4 == 0);
         assert(w % 2 == 0);
 
-        canvas_.assign(h / 4, std::vector<Dots>(w / 2));
-        colors_.assign(h / 4, std::vector<tui::Color>(w / 2, tui::Color::kWhite));
+        canvas_.assign(h_ * w_, Dots());
+        colors_.assign(h_ * w_, tui::Color::kWhite);
+    }
+
+    // Same as constructing anew, but keeps the storage when it is big enough.
+    void Resize(int h, int w) {
+        assert(h % 4 == 0);
+        assert(w % 2 == 0);
+
+        h_ = h / 4;
+        w_ = w / 2;
+        canvas_.assign(h_ * w_, Dots());
+        colors_.assign(h_ * w_, tui::Color::kWhite);
     }
 
     void Set(int y, int x, bool state) {
-        canvas_.at(y / 4).at(x / 2).Set(y % 4, x % 2, state);
+        assert(y >= 0 && y / 4 < h_ && x >= 0 && x / 2 < w_);
+        canvas_[y / 4 * w_ + x / 2].Set(y % 4, x % 2, state);
     }
 
     void SetColor(int block_y, int block_x, tui::Color color) {
-        colors_.at(block_y).at(block_x) = color;
+        assert(block_y >= 0 && block_y < h_ && block_x >= 0 && block_x < w_);
+        colors_[block_y * w_ + block_x] = color;
+    }
+
+    // Raw rows of cells for bulk writers, `Width()` entries each.
+    Dots* DotsRow(int block_y) {
+        assert(block_y >= 0 && block_y < h_);
+        return canvas_.data() + block_y * w_;
+    }
+
+    tui::Color* ColorRow(int block_y) {
+        assert(block_y >= 0 && block_y < h_);
+        return colors_.data() + block_y * w_;
     }
 
-    tui::Object::Rectangle BuildChars() const {
-        tui::Object::Rectangle result(
-            canvas_.size(), std::vector<tui::Char>(canvas_.at(0).size()));
-        for (size_t i = 0; i < canvas_.size(); ++i) {
-            for (size_t j = 0; j < canvas_[0].size(); ++j) {
-                result[i][j] = { .unicode = canvas_[i][j].Get(), .fg = colors_[i][j] };
+    tui::Object::Rectangle BuildChars(std::pmr::memory_resource* resource) const {
+        auto result = Blank(resource);
+        for (int i = 0; i < h_; ++i) {
+            for (int j = 0; j < w_; ++j) {
+                result[i][j] = { .unicode = canvas_[i * w_ + j].Get(), .fg = colors_[i * w_ + j] };
             }
         }
         return result;
     }
 
 private:
-    template<typename T>
-    struct Coord {
-        T y;
-        T x;
-    };
-
-    std::vector<std::vector<Dots>> canvas_;
-    std::vector<std::vector<tui::Color>>  colors_;
+    std::vector<Dots> canvas_;
+    std::vector<tui::Color> colors_;
 };
 
 }  // namespace braille
@@ -13,20 +13,26 @@ namespace braille {
 // 4 cols x 2 rows
 class Dots {
 public:
+    // Bit of the dot at row `y` and column `x` in the cell's state.
+    static constexpr uint8_t Bit(int y, int x) {
+        return y < 3 ? 1u << (3 * x + y) : 1u << (6 + x);
+    }
+
+    Dots() = default;
+
+    explicit Dots(uint8_t state)
+        : state_(state)
+    {
+    }
+
     void Set(int y, int x, bool state) {
         assert(y >= 0 && y < 4);
         assert(x >= 0 && x < 2);
 
-        uint8_t bit;
-        if (y < 3) {
-            bit = (1u << (3 * x + y));
-        } else {
-            bit = (1u << (6 + x));
-        }
         if (state == true) {
-            state_ |= bit;
+            state_ |= Bit(y, x);
         } else {
-            state_ &= ~bit;
+            state_ &= ~Bit(y, x);
         }
     }
     
@@ -34,6 +40,10 @@ public:
         return L'\u2800' + state_;
     }
 
+    uint8_t State() const {
+        return state_;
+    }
+
 private:
     uint8_t state_ = 0;
 };
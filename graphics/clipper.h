@@ -0,0 +1,135 @@
+#pragma once
+
+#include "math/common.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace graphics {
+
+// Clipping to the view volume -w <= x, y, z <= w, done in homogeneous
+// coordinates before the perspective divide so that it also handles
+// geometry behind the camera.
+namespace clip {
+
+constexpr int kPlanes = 6;
+
+// Signed distance to one of the planes, scaled and non-negative inside.
+// Plane 2 * i bounds coordinate i from below and plane 2 * i + 1 from above.
+inline float Distance(const math::Vec4& v, int plane) {
+    auto coordinate = v[plane / 2];
+    return plane % 2 == 0 ? v.w + coordinate : v.w - coordinate;
+}
+
+// Bit `plane` is set if the point lies outside of that plane.
+inline uint8_t Outcode(const math::Vec4& v) {
+    return (v.x < -v.w) << 0 | (v.x > v.w) << 1
+        | (v.y < -v.w) << 2 | (v.y > v.w) << 3
+        | (v.z < -v.w) << 4 | (v.z > v.w) << 5;
+}
+
+// Polygon vertex remembering its barycentric coordinates in the triangle
+// the polygon was cut from.
+struct Vertex {
+    math::Vec4 pos;
+    math::Vec3 bary;
+};
+
+// Every plane adds at most one vertex to a convex polygon.
+constexpr size_t kMaxVertices = 3 + kPlanes;
+
+struct Polygon {
+    std::array<Vertex, kMaxVertices> vertices;
+    size_t size = 0;
+};
+
+// Sutherland-Hodgman clipping of a triangle, the result is a convex polygon
+// with its vertices in the same winding, or empty.
+inline Polygon Triangle(const math::Vec4& a, const math::Vec4& b, const math::Vec4& c) {
+    Polygon result;
+    result.vertices[0] = {a, {1, 0, 0}};
+    result.vertices[1] = {b, {0, 1, 0}};
+    result.vertices[2] = {c, {0, 0, 1}};
+    result.size = 3;
+
+    auto outside = Outcode(a) | Outcode(b) | Outcode(c);
+    if ((Outcode(a) & Outcode(b) & Outcode(c)) != 0) {
+        result.size = 0;
+        return result;
+    }
+
+    Polygon scratch;
+    auto* from = &result;
+    auto* to = &scratch;
+    for (int plane = 0; plane < kPlanes; ++plane) {
+        if (!(outside >> plane & 1)) {
+            continue;
+        }
+        to->size = 0;
+        for (size_t i = 0; i < from->size; ++i) {
+            const auto& current = from->vertices[i];
+            const auto& next = from->vertices[i + 1 == from->size ? 0 : i + 1];
+            auto d_current = Distance(current.pos, plane);
+            auto d_next = Distance(next.pos, plane);
+            if (d_current >= 0) {
+                to->vertices[to->size++] = current;
+            }
+            if ((d_current >= 0) != (d_next >= 0)) {
+                auto ratio = d_current / (d_current - d_next);
+                to->vertices[to->size++] = {
+                    math::Blend(current.pos, next.pos, ratio),
+                    math::Blend(current.bary, next.bary, ratio),
+                };
+            }
+        }
+        std::swap(from, to);
+        if (from->size < 3) {
+            result.size = 0;
+            return result;
+        }
+    }
+    if (from != &result) {
+        result = *from;
+    }
+    return result;
+}
+
+// Clips the segment in place, returns false if nothing of it is visible.
+inline bool Segment(math::Vec4& a, math::Vec4& b) {
+    auto code_a = Outcode(a);
+    auto code_b = Outcode(b);
+    if ((code_a & code_b) != 0) {
+        return false;
+    }
+    if ((code_a | code_b) == 0) {
+        return true;
+    }
+    float enter = 0;
+    float exit = 1;
+    for (int plane = 0; plane < kPlanes; ++plane) {
+        auto d_a = Distance(a, plane);
+        auto d_b = Distance(b, plane);
+        if (d_a < 0 && d_b < 0) {
+            return false;
+        }
+        if (d_a < 0) {
+            enter = std::max(enter, d_a / (d_a - d_b));
+        } else if (d_b < 0) {
+            exit = std::min(exit, d_a / (d_a - d_b));
+        }
+    }
+    if (enter > exit) {
+        return false;
+    }
+    auto from = a;
+    a = math::Blend(from, b, enter);
+    b = math::Blend(from, b, exit);
+    return true;
+}
+
+}  // namespace clip
+
+}  // namespace graphics
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "graphics/clipper.h"
+#include "math/common.h"
+#include "math/transform.h"
+#include "tui/color.h"
+
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace graphics {
+
+// Vertex buffer plus index buffers for polygons and segments referencing it.
+class Mesh {
+public:
+    struct Face {
+        uint32_t first;
+        uint32_t size;
+        tui::Color fill;
+        tui::Color outer;
+        // Size of the face in texture tiles along its first and last edge.
+        math::Vec2 extent;
+    };
+
+    struct Edge {
+        uint32_t a;
+        uint32_t b;
+        tui::Color color;
+    };
+
+    void Clear() {
+        vertices_.clear();
+        indices_.clear();
+        faces_.clear();
+        edges_.clear();
+    }
+
+    uint32_t AddVertex(const math::Vec4& vertex) {
+        vertices_.push_back(vertex);
+        return vertices_.size() - 1;
+    }
+
+    void AddFace(std::initializer_list<uint32_t> corners, tui::Color fill, tui::Color outer = tui::Color::kDefault,
+            math::Vec2 extent = {1.0, 1.0}) {
+        assert(corners.size() >= 3);
+        faces_.push_back({
+            .first = static_cast<uint32_t>(indices_.size()),
+            .size = static_cast<uint32_t>(corners.size()),
+            .fill = fill,
+            .outer = outer,
+            .extent = extent,
+        });
+        indices_.insert(indices_.end(), corners);
+    }
+
+    void AddEdge(uint32_t a, uint32_t b, tui::Color color) {
+        edges_.push_back({.a = a, .b = b, .color = color});
+    }
+
+    const std::vector<math::Vec4>& Vertices() const {
+        return vertices_;
+    }
+
+    const std::vector<Face>& Faces() const {
+        return faces_;
+    }
+
+    const std::vector<Edge>& Edges() const {
+        return edges_;
+    }
+
+    std::span<const uint32_t> Corners(const Face& face) const {
+        return {indices_.data() + face.first, face.size};
+    }
+
+private:
+    std::vector<math::Vec4> vertices_;
+    std::vector<uint32_t> indices_;
+    std::vector<Face> faces_;
+    std::vector<Edge> edges_;
+};
+
+// Clip-space positions of a mesh's vertices, computed once per frame and
+// shared by every face and edge referencing them.
+class VertexCache {
+public:
+    void Transform(const math::Mat4& mvp, const Mesh& mesh) {
+        const auto& vertices = mesh.Vertices();
+        clip_.resize(vertices.size());
+        outcodes_.resize(vertices.size());
+        math::Transform(mvp, vertices, clip_);
+        for (size_t i = 0; i < clip_.size(); ++i) {
+            outcodes_[i] = clip::Outcode(clip_[i]);
+        }
+    }
+
+    const math::Vec4& operator[](uint32_t i) const {
+        return clip_[i];
+    }
+
+    // True if all of the vertices lie outside the same frustum plane.
+    bool Rejects(std::span<const uint32_t> indices) const {
+        uint8_t common = 0x3f;
+        for (auto i : indices) {
+            common &= outcodes_[i];
+        }
+        return common != 0;
+    }
+
+private:
+    std::vector<math::Vec4> clip_;
+    std::vector<uint8_t> outcodes_;
+};
+
+}  // namespace graphics
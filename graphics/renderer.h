@@ -1,39 +1,148 @@
 #pragma once
 
+#include "graphics/clipper.h"
+#include "graphics/mesh.h"
 #include "graphics/texture.h"
+#include "graphics/thread_pool.h"
 #include "math/common.h"
 #include "tui/color.h"
 
-#include <map>
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
 #include <ostream>
-#include <set>
+#include <span>
 #include <vector>
-#include <unordered_map>
 #include <sstream>
 
 namespace graphics {
 
 class Renderer {
 public:
+    static constexpr float kFarDepth = 1000.0;
+    // Coverage mask of a pixel with all of its samples inside.
+    static constexpr uint8_t kFullCoverage = 0xf;
+
     struct Pixel {
-        float z = 1000.0;
+        float z = kFarDepth;
         tui::Color color = tui::Color::kDefault;
 
         bool Defined() const {
+            return Defined(z, color);
+        }
+
+        static bool Defined(float z, tui::Color color) {
             return z < 999.0 && color != tui::Color::kDefault;
         }
     };
 
+    // Pixel position with clip space z and w, depth is z / w.
+    struct Pos {
+        int x;
+        int y;
+        float z;
+        float w;
+    };
+
     Renderer(int h, int w)
         : h_(h)
         , w_(w)
-        , pixels_(h, std::vector<Pixel>(w))
+        , depth_(h * w, kFarDepth)
+        , colors_(h * w, tui::Color::kDefault)
+        , outline_(h * w, kNoOutline)
+        , coverage_(h * w, 0)
+        , coarse_w_((w + kCoarseSize - 1) / kCoarseSize)
+        , coarse_max_(coarse_w_ * ((h + kCoarseSize - 1) / kCoarseSize), kFarDepth)
+        , coarse_dirty_(coarse_max_.size(), false)
     {
         assert(h_ > 0 && w_ > 0);
     }
 
+    // Changes the target size, reusing the storage when it is big enough.
+    // The frame is cleared.
+    void Resize(int h, int w) {
+        assert(h > 0 && w > 0);
+        Flush();
+        h_ = h;
+        w_ = w;
+        depth_.assign(h * w, kFarDepth);
+        colors_.assign(h * w, tui::Color::kDefault);
+        outline_.assign(h * w, kNoOutline);
+        coverage_.assign(h * w, 0);
+        coarse_w_ = (w + kCoarseSize - 1) / kCoarseSize;
+        coarse_max_.assign(coarse_w_ * ((h + kCoarseSize - 1) / kCoarseSize), kFarDepth);
+        coarse_dirty_.assign(coarse_max_.size(), false);
+        bins_.resize(pool_ ? TilesX() * TilesY() : 0);
+    }
+
+    // Resets the frame in place, keeping all the storage.
+    void Clear() {
+        std::fill(depth_.begin(), depth_.end(), kFarDepth);
+        std::fill(colors_.begin(), colors_.end(), tui::Color::kDefault);
+        std::fill(coverage_.begin(), coverage_.end(), 0);
+        std::fill(coarse_max_.begin(), coarse_max_.end(), kFarDepth);
+        std::fill(coarse_dirty_.begin(), coarse_dirty_.end(), false);
+        DiscardBins();
+    }
+
+    // With `threads` > 0 draws are only recorded into per-tile bins, which
+    // Flush() rasterizes in parallel with every tile owned by one thread.
+    // Virtual textures passed to DrawTriangle must then live until Flush().
+    void EnableBinning(int threads) {
+        Flush();
+        pool_ = threads > 0 ? std::make_unique<ThreadPool>(threads - 1) : nullptr;
+        bins_.resize(pool_ ? TilesX() * TilesY() : 0);
+    }
+
+    // Tests triangle edges at 2x2 samples per pixel and keeps which of them
+    // are covered, while depth and texture stay per pixel. Rendering at half
+    // the resolution then still gives every braille dot its own sample, for a
+    // quarter of the depth tests and texture lookups. The frame is cleared.
+    void EnableCoverage(bool enabled) {
+        Flush();
+        coverage_enabled_ = enabled;
+        Clear();
+    }
+
+    bool CoverageEnabled() const {
+        return coverage_enabled_;
+    }
+
+    // Rasterizes everything recorded since the last flush, a no-op without
+    // binning. Reading pixels before it returns misses the recorded draws.
+    void Flush() {
+        if (!pool_) {
+            return;
+        }
+        pool_->Run(bins_.size(), [this](int tile) {
+            int min_x = tile % TilesX() * kTileWidth;
+            int min_y = tile / TilesX() * kTileHeight;
+            Scissor scissor{
+                .min_x = min_x,
+                .min_y = min_y,
+                .max_x = std::min(w_, min_x + kTileWidth) - 1,
+                .max_y = std::min(h_, min_y + kTileHeight) - 1,
+            };
+            for (const auto& command : bins_[tile]) {
+                if (command.kind == Command::kPoint) {
+                    const auto& point = points_[command.index];
+                    Plot(point.pos, point.color, point.outline);
+                } else {
+                    const auto& triangle = triangles_[command.index];
+                    (this->*triangle.rasterize)(triangle, scissor);
+                }
+            }
+        });
+        DiscardBins();
+    }
+
     int Width() const {
         return w_;
     }
@@ -42,8 +151,25 @@ public:
         return h_;
     }
 
-    const Pixel& Get(int y, int x) const {
-        return pixels_.at(y).at(x);
+    Pixel Get(int y, int x) const {
+        assert(y >= 0 && y < h_ && x >= 0 && x < w_);
+        return {.z = depth_[y * w_ + x], .color = colors_[y * w_ + x]};
+    }
+
+    // Unchecked row-major access to the depth and color planes.
+    const float* DepthRow(int y) const {
+        return depth_.data() + y * w_;
+    }
+
+    const tui::Color* ColorRow(int y) const {
+        return colors_.data() + y * w_;
+    }
+
+    // Covered samples of every pixel, bit 2 * sy + sx for the sample in row
+    // `sy` and column `sx` of its 2x2 grid. Only kept with coverage enabled,
+    // points and segments cover whole pixels.
+    const uint8_t* CoverageRow(int y) const {
+        return coverage_.data() + y * w_;
     }
 
     void DrawDot(const math::Vec4& dot, tui::Color color) {
@@ -52,269 +178,621 @@ public:
     }
 
     void DrawSegment(math::Vec4 a, math::Vec4 b, tui::Color color) {
-        auto points = DumpSegmentPoints(a, b);
-        for (const auto& pt : points) {
-            Set(pt, color);
+        VisitSegment(a, b, [&](const Pos& pos) {
+            Set(pos, color);
+        });
+    }
+
+    // Calls `visit(pos)` for every pixel of the clipped segment from `a` to
+    // `b`, with the depth already divided so that `pos.w` is 1.
+    template<typename F>
+    void VisitSegment(math::Vec4 a, math::Vec4 b, F&& visit) const {
+        if (!clip::Segment(a, b) || a.w <= 0 || b.w <= 0) {
+            return;
+        }
+        auto z = a.z / a.w;
+        auto z_end = b.z / b.w;
+        a = Remap(a);
+        b = Remap(b);
+
+        // Bresenham over the rounded end points, the depth is affine along
+        // the segment on screen and advances by the same step every pixel.
+        int x = a.x;
+        int y = a.y;
+        int x_end = b.x;
+        int y_end = b.y;
+        int dx = std::abs(x_end - x);
+        int dy = -std::abs(y_end - y);
+        int step_x = x < x_end ? 1 : -1;
+        int step_y = y < y_end ? 1 : -1;
+        int steps = std::max(dx, -dy);
+        auto dz = steps == 0 ? 0 : (z_end - z) / steps;
+        for (int error = dx + dy; ; z += dz) {
+            visit(Pos{x, y, z, 1});
+            if (x == x_end && y == y_end) {
+                break;
+            }
+            auto doubled = 2 * error;
+            if (doubled >= dy) {
+                error += dy;
+                x += step_x;
+            }
+            if (doubled <= dx) {
+                error += dx;
+                y += step_y;
+            }
         }
     }
 
     void DrawTriangle(math::Vec4 a, math::Vec4 b, math::Vec4 c) {
-        DrawTriangle(a, b, c, SolidTexture(tui::Color::kWhite), {});
+        DrawTriangle(a, b, c, StaticSolidTexture{tui::Color::kWhite});
     }
 
-    void DrawPolygon(std::vector<math::Vec4> verts, tui::Color outer, tui::Color fill = tui::Color::kDefault) {
-        DrawPolygon(std::move(verts), outer, SolidPolytexture(fill));
+    void DrawPolygon(const std::vector<math::Vec4>& verts, tui::Color outer, tui::Color fill = tui::Color::kDefault) {
+        DrawPolygon(std::span<const math::Vec4>(verts), outer, StaticSolidPolytexture{fill});
     }
 
     void DrawPolygon(const std::vector<math::Vec4>& verts, tui::Color outer, const Polytexture& polytexture) {
-        std::set<std::pair<int, int>> boundary;
-        for (size_t i = 0; i < verts.size(); ++i) {
-            size_t j = i + 1;
-            if (j == verts.size()) {
-                j = 0;
-            }
-            for (const auto& pt : DumpSegmentPoints(verts[i], verts[j])) {
-                boundary.emplace(pt.y, pt.x);
-                Set(pt, outer);
+        DrawPolygon(std::span<const math::Vec4>(verts), outer, polytexture);
+    }
+
+    // Draws a polygon of already transformed vertices, skipping it if all of
+    // the corners are outside of the same frustum plane.
+    template<typename P>
+    void DrawPolygon(const VertexCache& cache, std::span<const uint32_t> corners, tui::Color outer,
+            const P& polytexture) {
+        assert(corners.size() <= kMaxPolygon);
+        if (cache.Rejects(corners)) {
+            return;
+        }
+        std::array<math::Vec4, kMaxPolygon> verts;
+        for (size_t i = 0; i < corners.size(); ++i) {
+            verts[i] = cache[corners[i]];
+        }
+        DrawPolygon(std::span<const math::Vec4>(verts.data(), corners.size()), outer, polytexture);
+    }
+
+    void DrawSegment(const VertexCache& cache, uint32_t a, uint32_t b, tui::Color color) {
+        if (cache.Rejects(std::array{a, b})) {
+            return;
+        }
+        DrawSegment(cache[a], cache[b], color);
+    }
+
+    void DrawPolygon(std::span<const math::Vec4> verts, tui::Color outer, const Polytexture& polytexture) {
+        auto outline = DrawOutline(verts, outer);
+        for (size_t i = 1; i + 1 < verts.size(); ++i) {
+            auto texture = polytexture.Get(0, i, i + 1);
+            DrawTriangle(verts[0], verts[i], verts[i + 1], TextureRef{texture.get()}, outline);
+            if (pool_) {
+                retained_.push_back(std::move(texture));
             }
         }
+    }
 
+    template<StaticPolytexture P>
+    void DrawPolygon(std::span<const math::Vec4> verts, tui::Color outer, const P& polytexture) {
+        auto outline = DrawOutline(verts, outer);
         for (size_t i = 1; i + 1 < verts.size(); ++i) {
-            DrawTriangle(verts[0], verts[i], verts[i + 1], *polytexture.Get(0, i, i + 1), boundary);
+            DrawTriangle(verts[0], verts[i], verts[i + 1], polytexture.Get(0, i, i + 1), outline);
         }
     }
 
-    void DrawTriangle(math::Vec4 va, math::Vec4 vb, math::Vec4 vc, const Texture& texture) {
-        int min_x = std::min({va.x, vb.x, vc.x});
-        int min_y = std::min({va.y, vb.y, vc.y});
-        int max_x = std::max({va.x, vb.x, vc.x});
-        int max_y = std::max({va.y, vb.y, vc.y});
+    // Pixels marked with `outline` in the outline mask are left untouched,
+    // `kNoOutline` fills the whole triangle.
+    void DrawTriangle(math::Vec4 va, math::Vec4 vb, math::Vec4 vc, const Texture& texture,
+            uint32_t outline = kNoOutline) {
+        DrawTriangle(va, vb, vc, TextureRef{&texture}, outline);
+    }
 
-        std::set<std::pair<int, int>> boundary;
-        for (const auto& pt : DumpSegmentPoints(va, vb)) {
-            boundary.emplace(pt.y, pt.x);
+    template<StaticTexture T>
+    void DrawTriangle(math::Vec4 va, math::Vec4 vb, math::Vec4 vc, const T& texture, uint32_t outline = kNoOutline) {
+        auto polygon = clip::Triangle(va, vb, vc);
+        const auto& verts = polygon.vertices;
+        for (size_t i = 1; i + 1 < polygon.size; ++i) {
+            DrawClipped(verts[0], verts[i], verts[i + 1], texture, outline);
         }
-        for (const auto& pt : DumpSegmentPoints(vc, va)) {
-            boundary.emplace(pt.y, pt.x);
+    }
+
+private:
+    // Barycentric coordinates in the texture of each triangle vertex, the
+    // triangle may be a piece of the one the texture was made for.
+    struct BaryMap {
+        math::Vec3 a;
+        math::Vec3 b;
+        math::Vec3 c;
+    };
+
+    template<StaticTexture T>
+    void DrawClipped(const clip::Vertex& va, const clip::Vertex& vb, const clip::Vertex& vc, const T& texture,
+            uint32_t outline) {
+        if (va.pos.w <= 0 || vb.pos.w <= 0 || vc.pos.w <= 0) {
+            return;
         }
-        for (const auto& pt : DumpSegmentPoints(vb, vc)) {
-            boundary.emplace(pt.y, pt.x);
+        TriangleCommand triangle{
+            .a = Remap(va.pos),
+            .b = Remap(vb.pos),
+            .c = Remap(vc.pos),
+            .map = {va.bary, vb.bary, vc.bary},
+            .outline = outline,
+        };
+        if (!pool_) {
+            Rasterize(triangle, texture, {.min_x = 0, .min_y = 0, .max_x = w_ - 1, .max_y = h_ - 1});
+            return;
         }
-
-        DrawTriangle(va, vb, vc, texture, boundary);
+        triangle.texture = Retain(texture);
+        triangle.rasterize = &Renderer::RasterizeRetained<T>;
+        Bin(triangle);
     }
 
-    class BaryTexture : public Texture {
-    public:
-        BaryTexture(const Texture& slave, math::Vec3 bary_a, math::Vec3 bary_b, math::Vec3 bary_c)
-            : slave_(slave)
-            , bary_a_(bary_a)
-            , bary_b_(bary_b)
-            , bary_c_(bary_c)
+private:
+    static constexpr uint32_t kNoOutline = 0;
+    static constexpr size_t kMaxPolygon = 8;
+    // Side of the blocks of the coarse depth buffer, divides the tile sizes
+    // so that every block belongs to a single tile.
+    static constexpr int kCoarseSize = 8;
+    // Offsets of the sample rows and columns from the pixel center.
+    static constexpr std::array<double, 2> kSampleOffsets = {-0.25, 0.25};
+
+    // Edge function E(x, y) = a * x + b * y + c of a directed edge, positive
+    // on the inner side of a triangle with positive area.
+    struct Edge {
+        Edge(const math::Vec4& from, const math::Vec4& to)
+            : a(static_cast<double>(from.y) - to.y)
+            , b(static_cast<double>(to.x) - from.x)
+            , c(-a * from.x - b * from.y)
+            , inclusive(a > 0 || (a == 0 && b > 0))
         {
         }
 
-        tui::Color Get(const math::Vec3& bary) const override {
-            return slave_.Get(bary.x * bary_a_ + bary.y * bary_b_ + bary.z * bary_c_);
+        double At(double x, double y) const {
+            return a * x + b * y + c;
         }
 
-    private:
-        const Texture& slave_;
-        math::Vec3 bary_a_;
-        math::Vec3 bary_b_;
-        math::Vec3 bary_c_;
+        double a;
+        double b;
+        double c;
+        // Top-left fill rule: pixel centers lying exactly on an edge belong
+        // to the triangle only for top and left edges, so triangles sharing
+        // an edge never both cover it.
+        bool inclusive;
     };
 
-#define piece(a, b, c, text) \
-        if (a.w < 1e-5) {\
-            if (b.w < c.w) {\
-                float ratio = (2 * 1e-5 - a.w) / (c.w - a.w);\
-                auto p = math::Blend(a, c, ratio);\
-                assert(p.w > 1e-5);\
-                DrawTriangle(b, p, c, BaryTexture(text, {0, 1, 0}, {1 - ratio, 0, ratio}, {0, 0, 1}), forbidden);\
-                DrawTriangle(b, p, a, BaryTexture(text, {0, 1, 0}, {1 - ratio, 0, ratio}, {1, 0, 0}), forbidden);\
-                return;\
-            } else {\
-                float ratio = (2 * 1e-5 - a.w) / (b.w - a.w);\
-                auto p = math::Blend(a, b, (2 * 1e-5 - a.w) / (b.w - a.w));\
-                assert(p.w > 1e-5);\
-                DrawTriangle(c, p, b, BaryTexture(text, {0, 0, 1}, {1 - ratio, ratio, 0}, {0, 1, 0}), forbidden);\
-                DrawTriangle(c, p, a, BaryTexture(text, {0, 0, 1}, {1 - ratio, ratio, 0}, {1, 0, 0}), forbidden);\
-                return;\
-            }\
-        }
+    // Inclusive pixel bounds a rasterization is limited to.
+    struct Scissor {
+        int min_x;
+        int min_y;
+        int max_x;
+        int max_y;
+    };
 
-    void DrawTriangle(math::Vec4 va, math::Vec4 vb, math::Vec4 vc, const Texture& texture,
-            const std::set<std::pair<int, int>>& forbidden) {
-        if (va.w < 1e-4 && vb.w < 1e-4 && vc.w < 1e-4) {
+    struct TriangleCommand {
+        math::Vec4 a;
+        math::Vec4 b;
+        math::Vec4 c;
+        BaryMap map;
+        uint32_t outline;
+        // Offset of the texture in `textures_` and the rasterizer for its type.
+        size_t texture = 0;
+        void (Renderer::*rasterize)(const TriangleCommand&, const Scissor&) = nullptr;
+    };
+
+    struct PointCommand {
+        Pos pos;
+        tui::Color color;
+        uint32_t outline;
+    };
+
+    struct Command {
+        enum Kind : uint8_t {
+            kPoint,
+            kTriangle,
+        };
+
+        Kind kind;
+        uint32_t index;
+    };
+
+    static constexpr int kTileWidth = 64;
+    static constexpr int kTileHeight = 32;
+    static_assert(kTileWidth % kCoarseSize == 0 && kTileHeight % kCoarseSize == 0);
+
+    int TilesX() const {
+        return (w_ + kTileWidth - 1) / kTileWidth;
+    }
+
+    int TilesY() const {
+        return (h_ + kTileHeight - 1) / kTileHeight;
+    }
+
+    int TileOf(int y, int x) const {
+        return y / kTileHeight * TilesX() + x / kTileWidth;
+    }
+
+    void Bin(const TriangleCommand& triangle) {
+        auto min_x = std::max(0.0f, std::min({triangle.a.x, triangle.b.x, triangle.c.x}));
+        auto min_y = std::max(0.0f, std::min({triangle.a.y, triangle.b.y, triangle.c.y}));
+        auto max_x = std::min<float>(w_ - 1, std::max({triangle.a.x, triangle.b.x, triangle.c.x}));
+        auto max_y = std::min<float>(h_ - 1, std::max({triangle.a.y, triangle.b.y, triangle.c.y}));
+        if (min_x > max_x || min_y > max_y) {
             return;
         }
-        piece(va, vb, vc, texture);
-        piece(vb, vc, va, BaryTexture(texture, {0, 1, 0}, {0, 0, 1}, {1, 0, 0}));
-        piece(vc, va, vb, BaryTexture(texture, {0, 0, 1}, {1, 0, 0}, {0, 1, 0}));
-        assert(va.w > 0 && vb.w > 0 && vc.w > 0);
-        std::set<std::pair<int, int>> boundary;
-        for (const auto& pt : DumpSegmentPoints(va, vb)) {
-            boundary.emplace(pt.y, pt.x);
-        }
-        for (const auto& pt : DumpSegmentPoints(vc, va)) {
-            boundary.emplace(pt.y, pt.x);
+        Command command{.kind = Command::kTriangle, .index = static_cast<uint32_t>(triangles_.size())};
+        triangles_.push_back(triangle);
+        for (int ty = static_cast<int>(min_y) / kTileHeight; ty <= static_cast<int>(max_y) / kTileHeight; ++ty) {
+            for (int tx = static_cast<int>(min_x) / kTileWidth; tx <= static_cast<int>(max_x) / kTileWidth; ++tx) {
+                bins_[ty * TilesX() + tx].push_back(command);
+            }
         }
-        for (const auto& pt : DumpSegmentPoints(vb, vc)) {
-            boundary.emplace(pt.y, pt.x);
+    }
+
+    // Copies a texture into the arena that keeps binned textures until Flush().
+    template<StaticTexture T>
+    size_t Retain(const T& texture) {
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+        auto offset = (textures_.size() + alignof(T) - 1) / alignof(T) * alignof(T);
+        textures_.resize(offset + sizeof(T));
+        std::memcpy(textures_.data() + offset, &texture, sizeof(T));
+        return offset;
+    }
+
+    template<StaticTexture T>
+    void RasterizeRetained(const TriangleCommand& triangle, const Scissor& scissor) {
+        Rasterize(triangle, *std::launder(reinterpret_cast<const T*>(textures_.data() + triangle.texture)), scissor);
+    }
+
+    void DiscardBins() {
+        for (auto& bin : bins_) {
+            bin.clear();
         }
-        if (boundary.empty()) {
-            return;
+        points_.clear();
+        triangles_.clear();
+        textures_.clear();
+        retained_.clear();
+    }
+
+    // Attribute that is affine in screen space, anchored at a vertex.
+    template<typename V>
+    struct Gradient {
+        float x0;
+        float y0;
+        V origin;
+        V dx;
+        V dy;
+
+        V At(float x, float y) const {
+            return origin + (x - x0) * dx + (y - y0) * dy;
         }
-        va = Remap(va);
-        vb = Remap(vb);
-        vc = Remap(vc);
-        int min_y = boundary.begin()->first;
-        int max_y = boundary.rbegin()->first;
+    };
 
-        auto area = [](const math::Vec4& a, const math::Vec4& b, const math::Vec4& c) {
-            math::Vec2 d1 = {static_cast<float>(a.x - b.x), static_cast<float>(a.y - b.y)};
-            math::Vec2 d2 = {static_cast<float>(c.x - b.x), static_cast<float>(c.y - b.y)};
-            return d1.x * d2.y - d1.y * d2.x;
+    template<typename V>
+    static Gradient<V> Interpolate(const std::array<Edge, 3>& edges, float inv_area, const math::Vec4& anchor,
+            V a, V b, V c) {
+        auto coefficient = [&](double Edge::* term) {
+            return static_cast<float>(edges[0].*term) * inv_area * a + static_cast<float>(edges[1].*term) * inv_area * b
+                + static_cast<float>(edges[2].*term) * inv_area * c;
         };
-        auto point_inside = [&](const math::Vec4& a, const math::Vec4& b, const math::Vec4& c, const math::Vec4& pt) {
-                auto abc_area = area(va, vb, vc);
-                return area(pt, vb, vc) / abc_area > 0 && area(va, pt, vc) / abc_area > 0 && area(va, vb, pt) / abc_area > 0;
-        };
-        auto abc_area = area(va, vb, vc);
+        return {.x0 = anchor.x, .y0 = anchor.y, .origin = a, .dx = coefficient(&Edge::a), .dy = coefficient(&Edge::b)};
+    }
+
+    template<StaticTexture T>
+    void Rasterize(const TriangleCommand& triangle, const T& texture, const Scissor& scissor) {
+        const auto& va = triangle.a;
+        const auto& vb = triangle.b;
+        const auto& vc = triangle.c;
+        std::array<Edge, 3> edges = {Edge(vb, vc), Edge(vc, va), Edge(va, vb)};
+        auto abc_area = edges[2].At(vc.x, vc.y);
+        if (abc_area == 0) {
+            return;
+        }
+        if (abc_area < 0) {
+            for (auto& edge : edges) {
+                edge.a = -edge.a;
+                edge.b = -edge.b;
+                edge.c = -edge.c;
+                edge.inclusive = edge.a > 0 || (edge.a == 0 && edge.b > 0);
+            }
+            abc_area = -abc_area;
+        }
+        auto inv_area = static_cast<float>(1.0 / abc_area);
+
+        // Depth after the perspective divide and 1 / w are affine in screen
+        // space, and so are the texture barycentrics divided by w.
+        std::array<float, 3> inv_w = {1 / va.w, 1 / vb.w, 1 / vc.w};
+        const auto& map = triangle.map;
+        auto depth = Interpolate(edges, inv_area, va, va.z * inv_w[0], vb.z * inv_w[1], vc.z * inv_w[2]);
+        auto one_over_w = Interpolate(edges, inv_area, va, inv_w[0], inv_w[1], inv_w[2]);
+        auto tex = Interpolate(edges, inv_area, va, inv_w[0] * map.a, inv_w[1] * map.b, inv_w[2] * map.c);
+
+        // Samples reach a bit further than pixel centers.
+        auto margin = coverage_enabled_ ? kSampleOffsets[1] : 0.0;
+        int min_y = std::max<double>(scissor.min_y, std::ceil(std::min({va.y, vb.y, vc.y}) - margin));
+        int max_y = std::min<double>(scissor.max_y, std::floor(std::max({va.y, vb.y, vc.y}) + margin));
+        int box_min_x = std::max<double>(scissor.min_x, std::ceil(std::min({va.x, vb.x, vc.x}) - margin));
+        int box_max_x = std::min<double>(scissor.max_x, std::floor(std::max({va.x, vb.x, vc.x}) + margin));
+        auto nearest = std::min({va.z * inv_w[0], vb.z * inv_w[1], vc.z * inv_w[2]});
+        if (Occluded(box_min_x, min_y, box_max_x, max_y, nearest)) {
+            return;
+        }
+        if (coverage_enabled_) {
+            auto farthest = std::max({va.z * inv_w[0], vb.z * inv_w[1], vc.z * inv_w[2]});
+            RasterizeCoverage(triangle, texture, edges, depth, one_over_w, tex, scissor, min_y, max_y,
+                nearest, farthest);
+            return;
+        }
         for (int y = min_y; y <= max_y; ++y) {
-            int min_x = -500;
-            int max_x = -500;
-            auto lower_iter = boundary.lower_bound({y, -1});
-            if (lower_iter == boundary.end() || lower_iter->first != y) {
-                min_x = 0;
-                max_x = w_ - 1;
-            } else {
-                auto iter = (--boundary.lower_bound({y + 1, -1}));
-                bool s_podvohom = false;
-                for (int i = lower_iter->second; i < iter->second; ++i) {
-                    if (!boundary.contains({lower_iter->first, i})) {
-                        s_podvohom = true;
-                        break;
-                    }
-                }
-                if (!s_podvohom) {
-                    if (point_inside(va, vb, vc, {1.0, static_cast<float>(y)})) {
-                        min_x = 0;
-                        max_x = lower_iter->second;
-                    } else if (point_inside(va, vb, vc, {static_cast<float>(w_ - 1.0), static_cast<float>(y)})) {
-                        min_x = lower_iter->second;
-                        max_x = w_ - 1;
-                    } else {
-                        // assert(false);
-                        min_x = max_x = lower_iter->second;
-                        // min_x = max_x = w_ - 5;
-                    }
-                } else {
-                    assert(iter->first == y && iter->second != lower_iter->second);
-                    min_x = lower_iter->second;
-                    max_x = iter->second;
-                    assert(min_x < max_x);
-                    Set({w_ - 10, y, 0}, tui::Color::kGreen);
+            int min_x;
+            int max_x;
+            if (!Span(edges, scissor, y, 0, min_x, max_x)) {
+                continue;
+            }
+
+            // The span is walked in pieces of one coarse block each, skipping
+            // the pieces that lie behind everything drawn in their block.
+            for (int from = min_x; from <= max_x;) {
+                int to = std::min(max_x, from | (kCoarseSize - 1));
+                auto coarse = CoarseIndex(y, from);
+                if (std::min(depth.At(from, y), depth.At(to, y)) - 1e-5 < coarse_max_[coarse]) {
+                    RasterizeSpan(triangle, texture, depth, one_over_w, tex, y, from, to);
                 }
+                from = to + 1;
             }
-            assert(min_x != -500 && max_x != -500);
-            /*
-            assert(lower_iter->first == y);
-            auto lower_x = std::max(0, lower_iter->second);
-            auto iter = (--boundary.lower_bound({y + 1, -1}));
-            assert(iter->first == y);
-            auto upper_x = std::min(w_ - 1, iter->second);
-            */
-
-            for (int x = min_x; x <= max_x; ++x) {
-                assert(x >= -10 && x <= w_ + 10);
-                if (forbidden.contains({y, x})) {
-                    continue;
+        }
+    }
+
+    // Each edge bounds the row from one side, so the covered pixels form a
+    // single span found by solving E(x + offset_x, y) >= 0 per edge.
+    static bool Span(const std::array<Edge, 3>& edges, const Scissor& scissor, double y, double offset_x,
+            int& min_x, int& max_x) {
+        min_x = scissor.min_x;
+        max_x = scissor.max_x;
+        for (const auto& edge : edges) {
+            auto row = edge.a * offset_x + edge.b * y + edge.c;
+            if (edge.a == 0) {
+                if (row < 0 || (row == 0 && !edge.inclusive)) {
+                    return false;
                 }
-                float fx = x;
-                float fy = y;
-                math::Vec3 bary{
-                    .x = area({fx, fy}, vb, vc) / abc_area,
-                    .y = area(va, {fx, fy}, vc) / abc_area,
-                    .z = area(va, vb, {fx, fy}) / abc_area,
-                };
-                auto z = bary.x * va.z + bary.y * vb.z + bary.z * vc.z;
-                auto w = bary.x * va.w + bary.y * vb.w + bary.z * vc.w;
-                Set({x, y, z, w}, texture.Get(bary));
+                continue;
+            }
+            auto t = -row / edge.a;
+            if (edge.a > 0) {
+                auto bound = edge.inclusive ? std::ceil(t) : std::floor(t) + 1;
+                min_x = static_cast<int>(std::max<double>(min_x, bound));
+            } else {
+                auto bound = edge.inclusive ? std::floor(t) : std::ceil(t) - 1;
+                max_x = static_cast<int>(std::min<double>(max_x, bound));
             }
         }
+        return min_x <= max_x;
     }
 
-    std::vector<std::vector<tui::Color>> BuildDownsampledColormap(int ys, int xs) const {
-        assert(xs > 0 && ys > 0);
-        assert(w_ % xs == 0 && h_ % ys == 0);
+    // Pixels of a row covered by each of the samples, empty if `from` > `to`.
+    struct SampleSpans {
+        std::array<int, 4> from;
+        std::array<int, 4> to;
+    };
 
-        std::vector<std::vector<tui::Color>> result(h_ / ys, std::vector<tui::Color>(w_ / xs, tui::Color::kDefault));
-        for (int i = 0; i < result.size(); ++i) {
-            for (int j = 0; j < result[0].size(); ++j) {
-                /*
-                std::unordered_map<tui::Color, int> occs;
-                for (int di = 0; di < ys; ++di) {
-                    for (int dj = 0; dj < xs; ++dj) {
-                        if (Get(i * ys + di, j * xs + dj).Defined()) {
-                            ++occs[Get(i * ys + di, j * xs + dj).color];
-                        }
-                    }
+    // Every sample of a pixel row has its own span, a pixel is drawn if any
+    // of its samples is covered. The coarse depth buffer is checked per piece
+    // like for pixel spans. Pixels on the edges take their depth at the
+    // center outside of the triangle, so it is clamped between the nearest
+    // and farthest vertex depth. Otherwise it could be nearer than the
+    // vertices, which the coarse rejection relies on.
+    template<StaticTexture T>
+    void RasterizeCoverage(const TriangleCommand& triangle, const T& texture, const std::array<Edge, 3>& edges,
+            const Gradient<float>& depth, const Gradient<float>& one_over_w, const Gradient<math::Vec3>& tex,
+            const Scissor& scissor, int min_y, int max_y, float nearest, float farthest) {
+        for (int y = min_y; y <= max_y; ++y) {
+            SampleSpans spans;
+            int min_x = scissor.max_x + 1;
+            int max_x = scissor.min_x - 1;
+            for (int sample = 0; sample < 4; ++sample) {
+                auto& from = spans.from[sample];
+                auto& to = spans.to[sample];
+                if (!Span(edges, scissor, y + kSampleOffsets[sample >> 1], kSampleOffsets[sample & 1], from, to)) {
+                    from = scissor.max_x + 1;
+                    to = scissor.min_x - 1;
                 }
-                auto max = 0;
-                auto argmax = tui::Color::kDefault;
-                for (const auto& [k, v] : occs) {
-                    if (v > max || (v == max && argmax < k)) {
-                        argmax = k;
-                        max = v;
-                    }
+                min_x = std::min(min_x, from);
+                max_x = std::max(max_x, to);
+            }
+            for (int from = min_x; from <= max_x;) {
+                int to = std::min(max_x, from | (kCoarseSize - 1));
+                auto coarse = CoarseIndex(y, from);
+                auto z = std::clamp(std::min(depth.At(from, y), depth.At(to, y)), nearest, farthest);
+                if (z - 1e-5 < coarse_max_[coarse]) {
+                    CoverSpan(triangle, texture, depth, one_over_w, tex, spans, y, from, to, nearest, farthest);
                 }
-                result[i][j] = argmax;
-                */
-                auto min = std::numeric_limits<double>::max();
-                auto closest = tui::Color::kDefault;
-                for (int di = 0; di < ys; ++di) {
-                    for (int dj = 0; dj < xs; ++dj) {
-                        const auto& pixel = Get(i * ys + di, j * xs + dj);
-                        if (pixel.Defined() && pixel.z < min) {
-                            closest = pixel.color;
-                            min = pixel.z;
-                        }
-                    }
+                from = to + 1;
+            }
+        }
+    }
+
+    template<StaticTexture T>
+    void CoverSpan(const TriangleCommand& triangle, const T& texture, const Gradient<float>& depth,
+            const Gradient<float>& one_over_w, const Gradient<math::Vec3>& tex, const SampleSpans& spans,
+            int y, int min_x, int max_x, float nearest, float farthest) {
+        // The samples of a row may leave a gap, so where it starts depends on
+        // the tile. Walking from the block boundary steps the attributes the
+        // same way with and without binning.
+        int start = min_x & ~(kCoarseSize - 1);
+        auto z = depth.At(start, y);
+        auto q = one_over_w.At(start, y);
+        auto t = tex.At(start, y);
+        bool written = false;
+        for (int x = start; x <= max_x; ++x, z += depth.dx, q += one_over_w.dx, t += tex.dx) {
+            if (x < min_x) {
+                continue;
+            }
+            uint8_t mask = 0;
+            for (int sample = 0; sample < 4; ++sample) {
+                mask |= (x >= spans.from[sample] && x <= spans.to[sample]) << sample;
+            }
+            auto index = y * w_ + x;
+            if (mask == 0 || (triangle.outline != kNoOutline && outline_[index] == triangle.outline)) {
+                continue;
+            }
+            auto center_z = std::clamp(z, nearest, farthest);
+            bool passes = Passes(index, center_z);
+            // Samples the surface in front left empty are filled from behind,
+            // the pixel keeps its color.
+            uint8_t uncovered = mask & ~coverage_[index];
+            if (!passes && uncovered == 0) {
+                continue;
+            }
+            auto color = texture.Get(t * (1 / q));
+            if (color == tui::Color::kTransparent) {
+                continue;
+            }
+            if (passes) {
+                depth_[index] = center_z;
+                colors_[index] = color;
+            }
+            coverage_[index] |= mask;
+            written = true;
+        }
+        if (written) {
+            coarse_dirty_[CoarseIndex(y, min_x)] = true;
+        }
+    }
+
+    template<StaticTexture T>
+    void RasterizeSpan(const TriangleCommand& triangle, const T& texture, const Gradient<float>& depth,
+            const Gradient<float>& one_over_w, const Gradient<math::Vec3>& tex, int y, int min_x, int max_x) {
+        auto z = depth.At(min_x, y);
+        auto q = one_over_w.At(min_x, y);
+        auto t = tex.At(min_x, y);
+        bool written = false;
+        for (int x = min_x; x <= max_x; ++x, z += depth.dx, q += one_over_w.dx, t += tex.dx) {
+            auto index = y * w_ + x;
+            if (triangle.outline != kNoOutline && outline_[index] == triangle.outline) {
+                continue;
+            }
+            // Shades only the pixels passing the depth test.
+            if (z < -1 || z > 1 || !Passes(index, z)) {
+                continue;
+            }
+            auto color = texture.Get(t * (1 / q));
+            if (color != tui::Color::kTransparent) {
+                depth_[index] = z;
+                colors_[index] = color;
+                written = true;
+            }
+        }
+        if (written) {
+            coarse_dirty_[CoarseIndex(y, min_x)] = true;
+        }
+    }
+
+    int CoarseIndex(int y, int x) const {
+        return y / kCoarseSize * coarse_w_ + x / kCoarseSize;
+    }
+
+    // Whether nothing at depth `z` or farther can pass the depth test inside
+    // the rectangle. Refreshes the maximum depth of modified blocks on the way.
+    bool Occluded(int min_x, int min_y, int max_x, int max_y, float z) {
+        for (int by = min_y / kCoarseSize; by <= max_y / kCoarseSize; ++by) {
+            for (int bx = min_x / kCoarseSize; bx <= max_x / kCoarseSize; ++bx) {
+                auto coarse = by * coarse_w_ + bx;
+                if (coarse_dirty_[coarse]) {
+                    coarse_max_[coarse] = BlockMaxDepth(by, bx);
+                    coarse_dirty_[coarse] = false;
+                }
+                // Passes() lets pixels without a color be overwritten from
+                // slightly behind.
+                if (z - 1e-5 < coarse_max_[coarse]) {
+                    return false;
                 }
-                result[i][j] = closest;
             }
         }
-        return result;
+        return true;
     }
 
-private:
-    struct Pos {
-        int x;
-        int y;
-        float z;
-        float w;
-    };
+    float BlockMaxDepth(int by, int bx) const {
+        float max = -std::numeric_limits<float>::infinity();
+        for (int y = by * kCoarseSize; y < std::min(h_, (by + 1) * kCoarseSize); ++y) {
+            const auto* depth = DepthRow(y);
+            const auto* coverage = CoverageRow(y);
+            for (int x = bx * kCoarseSize; x < std::min(w_, (bx + 1) * kCoarseSize); ++x) {
+                // Partly covered pixels still let through anything behind.
+                bool partial = coverage_enabled_ && coverage[x] != kFullCoverage;
+                max = std::max(max, partial ? kFarDepth : depth[x]);
+            }
+        }
+        return max;
+    }
 
-    void Set(Pos pos, tui::Color color) {
-        if (color == tui::Color::kTransparent) {
+    // Draws the closed outline of a polygon, returns the outline id its
+    // pixels were marked with.
+    uint32_t DrawOutline(std::span<const math::Vec4> verts, tui::Color outer) {
+        auto outline = NextOutline();
+        for (size_t i = 0; i < verts.size(); ++i) {
+            size_t j = i + 1;
+            if (j == verts.size()) {
+                j = 0;
+            }
+            VisitSegment(verts[i], verts[j], [&](const Pos& pos) {
+                Set(pos, outer, outline);
+            });
+        }
+        return outline;
+    }
+
+    uint32_t NextOutline() {
+        if (outline_id_ + 1 == kNoOutline) {
+            Flush();
+        }
+        if (++outline_id_ == kNoOutline) {
+            std::fill(outline_.begin(), outline_.end(), kNoOutline);
+            ++outline_id_;
+        }
+        return outline_id_;
+    }
+
+    // Draws a point, also marking it with `outline` in the outline mask.
+    void Set(Pos pos, tui::Color color, uint32_t outline = kNoOutline) {
+        if (!(pos.x >= 0 && pos.x < w_ && pos.y >= 0 && pos.y < h_)) {
             return;
         }
-        if (pos.z < -pos.w || pos.z > pos.w) {
+        if (!pool_) {
+            Plot(pos, color, outline);
             return;
         }
-        if (!(pos.x >= 0 && pos.x < w_ && pos.y >= 0 && pos.y < h_)) {
+        Command command{.kind = Command::kPoint, .index = static_cast<uint32_t>(points_.size())};
+        points_.push_back({.pos = pos, .color = color, .outline = outline});
+        bins_[TileOf(pos.y, pos.x)].push_back(command);
+    }
+
+    void Plot(Pos pos, tui::Color color, uint32_t outline) {
+        if (outline != kNoOutline) {
+            outline_[pos.y * w_ + pos.x] = outline;
+        }
+        Write(pos, color);
+    }
+
+    void Write(Pos pos, tui::Color color) {
+        if (color == tui::Color::kTransparent) {
+            return;
+        }
+        if (pos.z < -pos.w || pos.z > pos.w) {
             return;
         }
-        pos.z /= pos.w;
-        auto& pt = pixels_.at(pos.y).at(pos.x);
-        if (pos.z < pt.z || (pos.z - 1e-5 < pt.z && pt.color == tui::Color::kDefault)) {
-            pt.z = pos.z;
-            pt.color = color;
+        auto index = pos.y * w_ + pos.x;
+        auto z = pos.z / pos.w;
+        if (Passes(index, z)) {
+            depth_[index] = z;
+            colors_[index] = color;
+            coverage_[index] = kFullCoverage;
+            coarse_dirty_[CoarseIndex(pos.y, pos.x)] = true;
         }
     }
 
+    // Whether a pixel at depth `z` after the perspective divide would
+    // overwrite the stored one.
+    bool Passes(int index, float z) const {
+        return z < depth_[index] || (z - 1e-5 < depth_[index] && colors_[index] == tui::Color::kDefault);
+    }
+
     Pos Round(math::Vec4 floats) {
         return {
             .x = static_cast<int>(round(floats.x)),
@@ -324,7 +802,7 @@ private:
         };
     }
 
-    math::Vec4 Remap(math::Vec4 floats) {
+    math::Vec4 Remap(math::Vec4 floats) const {
         return {
             .x = std::round((floats.x / floats.w + 1) / 2 * w_),
             .y = std::round((floats.y / floats.w + 1) / 2 * h_),
@@ -333,107 +811,33 @@ private:
         };
     }
 
-    std::vector<Pos> DumpSegmentPoints(math::Vec4 a, math::Vec4 b) {
-        if (a.w < 1e-5 && b.w < 1e-5) {
-            return {};
-        }
-        if (a.w < 1e-5) {
-            a = math::Blend(a, b, (1e-5 - a.w) / (b.w - a.w));
-        }
-        if (b.w < 1e-5) {
-            b = math::Blend(b, a, (1e-5 - b.w) / (a.w - b.w));
-        }
-        a = Remap(a);
-        b = Remap(b);
-        if (a.x < 0 && b.x < 0 || a.y < 0 && b.y < 0 || a.x > w_ && b.x > w_ || a.y > h_ && b.y > h_) {
-            return {};
-        }
-        if (a.x < 0) {
-            a = math::Blend(a, b, -a.x / (b.x - a.x));
-        }
-        if (a.x < 0 && b.x < 0 || a.y < 0 && b.y < 0 || a.x > w_ && b.x > w_ || a.y > h_ && b.y > h_) {
-            return {};
-        }
-        if (a.y < 0) {
-            a = math::Blend(a, b, -a.y / (b.y - a.y));
-        }
-        if (a.x < 0 && b.x < 0 || a.y < 0 && b.y < 0 || a.x > w_ && b.x > w_ || a.y > h_ && b.y > h_) {
-            return {};
-        }
-        if (b.x < 0) {
-            b = math::Blend(b, a, -b.x / (-b.x + a.x));
-        }
-        if (a.x < 0 && b.x < 0 || a.y < 0 && b.y < 0 || a.x > w_ && b.x > w_ || a.y > h_ && b.y > h_) {
-            return {};
-        }
-        if (b.y < 0) {
-            b = math::Blend(b, a, -b.y / (-b.y + a.y));
-        }
-        if (a.x < 0 && b.x < 0 || a.y < 0 && b.y < 0 || a.x > w_ && b.x > w_ || a.y > h_ && b.y > h_) {
-            return {};
-        }
-        if (a.x > w_) {
-            a = math::Blend(a, b, (w_ - a.x) / (b.x - a.x));
-        }
-        if (a.x < 0 && b.x < 0 || a.y < 0 && b.y < 0 || a.x > w_ && b.x > w_ || a.y > h_ && b.y > h_) {
-            return {};
-        }
-        if (b.x > w_) {
-            b = math::Blend(b, a, (w_ - b.x) / (a.x - b.x));
-        }
-        if (a.x < 0 && b.x < 0 || a.y < 0 && b.y < 0 || a.x > w_ && b.x > w_ || a.y > h_ && b.y > h_) {
-            return {};
-        }
-        if (a.y > h_) {
-            a = math::Blend(a, b, (h_ - a.y) / (b.y - a.y));
-        }
-        if (a.x < 0 && b.x < 0 || a.y < 0 && b.y < 0 || a.x > w_ && b.x > w_ || a.y > h_ && b.y > h_) {
-            return {};
-        }
-        if (b.y > h_) {
-            b = math::Blend(b, a, (h_ - b.y) / (a.y - b.y));
-        }
-        if (a.x < 0 && b.x < 0 || a.y < 0 && b.y < 0 || a.x > w_ && b.x > w_ || a.y > h_ && b.y > h_) {
-            return {};
-        }
-
-        std::vector<Pos> result;
-        if (std::abs(a.x - b.x) > std::abs(a.y - b.y)) {
-            int min = round(std::min(a.x, b.x));
-            int max = round(std::max(a.x, b.x));
-            if (a.x > b.x) {
-                std::swap(a, b);
-            }
-            if (std::abs(min - max) < 1e-5) {
-                return {Round(a)};
-            }
-            for (int x = min; x <= max; ++x) {
-                auto ratio = (float) (x - min) / (max - min);
-                auto pos = Round(math::Blend(a, b, ratio));
-                result.push_back(pos);
-            }
-        } else {
-            int min = round(std::min(a.y, b.y));
-            int max = round(std::max(a.y, b.y));
-            if (a.y > b.y) {
-                std::swap(a, b);
-            }
-            if (std::abs(min - max) < 1e-5) {
-                return {Round(a)};
-            }
-            for (int y = min; y <= max; ++y) {
-                auto ratio = (float) (y - min) / (max - min);
-                auto pos = Round(math::Blend(a, b, ratio));
-                result.push_back(pos);
-            }
-        }
-        return result;
-    }
-
     int h_;
     int w_;
 
-    std::vector<std::vector<Pixel>> pixels_;
+    std::vector<float> depth_;
+    std::vector<tui::Color> colors_;
+
+    // Per-pixel id of the last polygon whose outline covered the pixel.
+    std::vector<uint32_t> outline_;
+    uint32_t outline_id_ = kNoOutline;
+
+    // Covered samples per pixel, see CoverageRow().
+    std::vector<uint8_t> coverage_;
+    bool coverage_enabled_ = false;
+
+    // Maximum depth per kCoarseSize x kCoarseSize block, only an upper bound
+    // while the block is marked dirty.
+    int coarse_w_;
+    std::vector<float> coarse_max_;
+    std::vector<uint8_t> coarse_dirty_;
+
+    std::unique_ptr<ThreadPool> pool_;
+    std::vector<std::vector<Command>> bins_;
+    std::vector<PointCommand> points_;
+    std::vector<TriangleCommand> triangles_;
+    std::vector<std::byte> textures_;
+    // Virtual polygon textures kept alive until their triangles are drawn.
+    std::vector<std::unique_ptr<Texture>> retained_;
 };
 
 }  // namespace graphics
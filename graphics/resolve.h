@@ -0,0 +1,189 @@
+#pragma once
+
+#include "blocks/canvas.h"
+#include "braille/canvas.h"
+#include "braille/dots.h"
+#include "graphics/renderer.h"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+
+namespace graphics {
+
+// How a braille cell picks one color out of its 2x4 pixels.
+enum class ColorPolicy {
+    // The color of the pixel closest to the camera.
+    kNearest,
+    // The most frequent color, ties go to the nearer pixel.
+    kMajority,
+    // The color with the largest total weight, nearer pixels weighing more.
+    kWeighted,
+};
+
+namespace detail {
+
+struct Sample {
+    float z;
+    tui::Color color;
+};
+
+inline tui::Color PickColor(const std::array<Sample, 8>& samples, int count, ColorPolicy policy) {
+    if (count == 0) {
+        return tui::Color::kDefault;
+    }
+    int nearest = 0;
+    for (int k = 1; k < count; ++k) {
+        if (samples[k].z < samples[nearest].z) {
+            nearest = k;
+        }
+    }
+    if (policy == ColorPolicy::kNearest) {
+        return samples[nearest].color;
+    }
+
+    auto best = samples[nearest].color;
+    float best_score = 0;
+    for (int k = 0; k < count; ++k) {
+        float score = 0;
+        for (int l = 0; l < count; ++l) {
+            if (samples[l].color == samples[k].color) {
+                // Depth is in [-1, 1] after the perspective divide.
+                score += policy == ColorPolicy::kMajority ? 1 : 1 - samples[l].z;
+            }
+        }
+        if (score > best_score || (score == best_score && samples[k].color == samples[nearest].color)) {
+            best = samples[k].color;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+// Dots of the cell lit by a coverage mask of its upper (0) or lower (1)
+// pixel. A dot is lit when its sample is covered, so its coverage is
+// thresholded at one half.
+constexpr std::array<std::array<uint8_t, 16>, 2> BuildCoverageDots() {
+    std::array<std::array<uint8_t, 16>, 2> dots = {};
+    for (int half = 0; half < 2; ++half) {
+        for (int mask = 0; mask < 16; ++mask) {
+            for (int sample = 0; sample < 4; ++sample) {
+                if (mask >> sample & 1) {
+                    dots[half][mask] |= braille::Dots::Bit(2 * half + (sample >> 1), sample & 1);
+                }
+            }
+        }
+    }
+    return dots;
+}
+
+// Resolve() of a renderer with coverage, which has a pixel per 2x2 dots.
+inline void ResolveCoverage(const Renderer& renderer, braille::Canvas& canvas, ColorPolicy policy) {
+    assert(renderer.Width() == canvas.Width());
+    assert(renderer.Height() == 2 * canvas.Height());
+
+    static constexpr auto kDots = BuildCoverageDots();
+
+    for (int i = 0; i < canvas.Height(); ++i) {
+        std::array<const float*, 2> depth;
+        std::array<const tui::Color*, 2> colors;
+        std::array<const uint8_t*, 2> coverage;
+        for (int half = 0; half < 2; ++half) {
+            depth[half] = renderer.DepthRow(2 * i + half);
+            colors[half] = renderer.ColorRow(2 * i + half);
+            coverage[half] = renderer.CoverageRow(2 * i + half);
+        }
+        auto* dots = canvas.DotsRow(i);
+        auto* cell_colors = canvas.ColorRow(i);
+        for (int j = 0; j < canvas.Width(); ++j) {
+            // Each lit dot adds its pixel as a sample, so the policies count
+            // dots like at full resolution. Compacted as in Resolve().
+            uint8_t state = 0;
+            std::array<Sample, 8> samples;
+            int count = 0;
+            for (int half = 0; half < 2; ++half) {
+                auto z = depth[half][j];
+                auto color = colors[half][j];
+                uint8_t mask = coverage[half][j] & -uint8_t{Renderer::Pixel::Defined(z, color)};
+                state |= kDots[half][mask];
+                for (int sample = 0; sample < 4; ++sample) {
+                    samples[count] = {.z = z, .color = color};
+                    count += mask >> sample & 1;
+                }
+            }
+            dots[j] = braille::Dots(state);
+            cell_colors[j] = PickColor(samples, count, policy);
+        }
+    }
+}
+
+}  // namespace detail
+
+// Fills both the dots and the colors of the canvas in one pass over the
+// renderer, which is 2x4 times larger than the canvas, or 1x2 times with
+// coverage enabled. Every cell is overwritten, so the canvas can be reused
+// between frames.
+inline void Resolve(const Renderer& renderer, braille::Canvas& canvas, ColorPolicy policy = ColorPolicy::kNearest) {
+    if (renderer.CoverageEnabled()) {
+        detail::ResolveCoverage(renderer, canvas, policy);
+        return;
+    }
+    assert(renderer.Width() == 2 * canvas.Width());
+    assert(renderer.Height() == 4 * canvas.Height());
+
+    static constexpr std::array<std::array<uint8_t, 2>, 4> kBits = {{
+        {braille::Dots::Bit(0, 0), braille::Dots::Bit(0, 1)},
+        {braille::Dots::Bit(1, 0), braille::Dots::Bit(1, 1)},
+        {braille::Dots::Bit(2, 0), braille::Dots::Bit(2, 1)},
+        {braille::Dots::Bit(3, 0), braille::Dots::Bit(3, 1)},
+    }};
+
+    for (int i = 0; i < canvas.Height(); ++i) {
+        std::array<const float*, 4> depth;
+        std::array<const tui::Color*, 4> colors;
+        for (int dy = 0; dy < 4; ++dy) {
+            depth[dy] = renderer.DepthRow(4 * i + dy);
+            colors[dy] = renderer.ColorRow(4 * i + dy);
+        }
+        auto* dots = canvas.DotsRow(i);
+        auto* cell_colors = canvas.ColorRow(i);
+        for (int j = 0; j < canvas.Width(); ++j) {
+            // Masks instead of branches keep the loop free of jumps. Every
+            // pixel is stored as a sample, but only defined ones advance the
+            // count, so the samples end up compacted without a branch.
+            uint8_t state = 0;
+            std::array<detail::Sample, 8> samples;
+            int count = 0;
+            for (int dy = 0; dy < 4; ++dy) {
+                for (int dx = 0; dx < 2; ++dx) {
+                    auto z = depth[dy][2 * j + dx];
+                    auto color = colors[dy][2 * j + dx];
+                    uint8_t defined = Renderer::Pixel::Defined(z, color);
+                    state |= kBits[dy][dx] & -defined;
+                    samples[count] = {.z = z, .color = color};
+                    count += defined;
+                }
+            }
+            dots[j] = braille::Dots(state);
+            cell_colors[j] = detail::PickColor(samples, count, policy);
+        }
+    }
+}
+
+// Copies the colors of the defined pixels into a block canvas with as many
+// sub-pixels as the renderer has pixels, leaving the rest empty.
+inline void Resolve(const Renderer& renderer, blocks::Canvas& canvas) {
+    assert(renderer.Width() == canvas.PixelWidth());
+    assert(renderer.Height() == canvas.PixelHeight());
+
+    for (int i = 0; i < renderer.Height(); ++i) {
+        const auto* depth = renderer.DepthRow(i);
+        const auto* colors = renderer.ColorRow(i);
+        auto* pixels = canvas.Row(i);
+        for (int j = 0; j < renderer.Width(); ++j) {
+            pixels[j] = Renderer::Pixel::Defined(depth[j], colors[j]) ? colors[j] : tui::Color::kDefault;
+        }
+    }
+}
+
+}  // namespace graphics
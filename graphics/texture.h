@@ -2,7 +2,10 @@
 
 #include "math/common.h"
 #include "tui/color.h"
+
+#include <concepts>
 #include <memory>
+#include <type_traits>
 
 namespace graphics {
 
@@ -78,5 +81,44 @@ private:
     tui::Color inner_;
 };
 
+// Texture known at compile time. The renderer copies it by value and
+// inlines its Get into the pixel loop instead of calling through a vtable.
+template<typename T>
+concept StaticTexture = std::is_trivially_copyable_v<T> && requires(const T& texture, const math::Vec3& bary) {
+    { texture.Get(bary) } -> std::same_as<tui::Color>;
+};
+
+// Polytexture known at compile time, handing out StaticTextures by value.
+template<typename T>
+concept StaticPolytexture = requires(const T& polytexture, size_t i) {
+    { polytexture.Get(i, i, i) } -> StaticTexture;
+};
+
+struct StaticSolidTexture {
+    tui::Color color;
+
+    tui::Color Get(const math::Vec3&) const {
+        return color;
+    }
+};
+
+struct StaticSolidPolytexture {
+    tui::Color inner;
+
+    StaticSolidTexture Get(size_t, size_t, size_t) const {
+        return {.color = inner};
+    }
+};
+
+// Draws a virtual texture through the static interface, one indirect call
+// per pixel. The texture must outlive the drawing.
+struct TextureRef {
+    const Texture* texture;
+
+    tui::Color Get(const math::Vec3& bary) const {
+        return texture->Get(bary);
+    }
+};
+
 }  // namespace graphics
 
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace graphics {
+
+// Fixed set of worker threads running batches of independent tasks.
+class ThreadPool {
+public:
+    // The calling thread takes part in every batch, so `threads` workers
+    // give `threads + 1` way parallelism.
+    explicit ThreadPool(int threads) {
+        assert(threads >= 0);
+        for (int i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { Work(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int Threads() const {
+        return workers_.size() + 1;
+    }
+
+    // Calls `task(i)` for every i in [0, count) and returns once all are done.
+    void Run(int count, const std::function<void(int)>& task) {
+        {
+            std::lock_guard lock(mutex_);
+            task_ = &task;
+            count_ = count;
+            next_ = 0;
+            busy_ = workers_.size();
+            ++batch_;
+        }
+        wake_.notify_all();
+        Drain();
+
+        std::unique_lock lock(mutex_);
+        done_.wait(lock, [this] { return busy_ == 0; });
+        task_ = nullptr;
+    }
+
+private:
+    void Work() {
+        uint64_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock lock(mutex_);
+                wake_.wait(lock, [&] { return stop_ || batch_ != seen; });
+                if (stop_) {
+                    return;
+                }
+                seen = batch_;
+            }
+            Drain();
+            std::lock_guard lock(mutex_);
+            if (--busy_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+
+    void Drain() {
+        for (int i = next_++; i < count_; i = next_++) {
+            (*task_)(i);
+        }
+    }
+
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(int)>* task_ = nullptr;
+    int count_ = 0;
+    std::atomic<int> next_ = 0;
+    size_t busy_ = 0;
+    uint64_t batch_ = 0;
+    bool stop_ = false;
+};
+
+}  // namespace graphics
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string_view>
+
 namespace input {
 
 enum class Key {
@@ -20,12 +22,19 @@ enum class Key {
 enum class Action {
     kKeyboard,
     kMouse,
+    kPaste,
 };
 
 struct Event {
     Action action;
     Key key;
+    // Consecutive presses of the same key merged into this event.
+    int repeat = 1;
+    // Cell of a mouse press, zero based.
+    int row = 0;
+    int column = 0;
+    // Pasted text, valid until the next batch is parsed.
+    std::string_view text = {};
 };
 
 }  // namespace input
-
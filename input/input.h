@@ -1,12 +1,14 @@
 #pragma once
 
 #include "event.h"
+#include "parser.h"
+#include "tui/utils.h"
 
 #include <cassert>
 #include <fcntl.h>
 #include <functional>
-#include <optional>
-#include <poll.h>
+#include <span>
+#include <string_view>
 #include <termios.h>
 #include <unistd.h>
 
@@ -17,124 +19,39 @@ public:
     EventPoller() {
         struct termios terminal;
         tcgetattr(STDIN_FILENO, &terminal);
-        on_destroy_ = [=] { tcsetattr(STDIN_FILENO, TCSANOW, &terminal); };
+        on_destroy_ = [=] {
+            Write(kReportingOff);
+            tcsetattr(STDIN_FILENO, TCSANOW, &terminal);
+        };
         terminal.c_lflag &= ~ICANON;
         terminal.c_lflag &= ~ECHO;
         terminal.c_cc[VMIN] = 0;
         terminal.c_cc[VTIME] = 0;
         tcsetattr(STDIN_FILENO, TCSANOW, &terminal);
+        Write(kReportingOn);
     }
 
     ~EventPoller() {
         on_destroy_();
     }
 
-    std::optional<Event> Poll() {
-        auto next = TryPeek();
-        if (!next) {
-            return std::nullopt;
-        }
-        if (next == '\033') {
-            if (!(next = TryPeek())) {
-                assert(false);
-            }
-            if (!(next = TryPeek())) {
-                assert(false);
-            }
-            switch (next) {
-                case 'A': {
-                    return Event{ Action::kKeyboard, Key::Up };
-                }
-                case 'B': {
-                    return Event{ Action::kKeyboard, Key::Down };
-                }
-                case 'C': {
-                    return Event{ Action::kKeyboard, Key::Left };
-                }
-                case 'D': {
-                    return Event{ Action::kKeyboard, Key::Right };
-                }
-                default: {
-                    return std::nullopt;
-                }
-            }
-        }
-        switch (next) {
-            case 'w':
-            case 'W': {
-                    return Event{ Action::kKeyboard, Key::W };
-            }
-            case 'a':
-            case 'A': {
-                    return Event{ Action::kKeyboard, Key::A };
-            }
-            case 's':
-            case 'S': {
-                    return Event{ Action::kKeyboard, Key::S };
-            }
-            case 'd':
-            case 'D': {
-                    return Event{ Action::kKeyboard, Key::D };
-            }
-            case 'j':
-            case 'J': {
-                    return Event{ Action::kKeyboard, Key::J };
-            }
-            case 'u':
-            case 'U': {
-                    return Event{ Action::kKeyboard, Key::U };
-            }
-            default: {
-                return std::nullopt;
-            }
-        }
+    // Decodes the bytes of one read into a batch of events, valid until
+    // the next call.
+    std::span<const Event> Feed(std::span<const char> bytes) {
+        return parser_.Parse(bytes);
     }
 
 private:
-    char TryPeek() {
-        if (start_ != end_) {
-            auto result = buff_[start_];
-            ++start_;
-            return result;
-        }
+    // Mouse button reports in the SGR encoding and bracketed paste.
+    static constexpr std::string_view kReportingOn = "\033[?1000h\033[?1006h\033[?2004h";
+    static constexpr std::string_view kReportingOff = "\033[?2004l\033[?1006l\033[?1000l";
 
-        struct pollfd pfd;
-
-        pfd.fd = STDIN_FILENO;
-        pfd.events = POLLIN;
-
-        if (!poll(&pfd, 1, 5) || !(pfd.revents & POLLIN)) {
-            return 0;
-        }
-
-        auto res = read(STDIN_FILENO, buff_, kBuffLen);
-        assert(res != -1);
-        end_ = res;
-        start_ = 0;
-
-        if (res == 0) {
-            assert(false);
-            return 0;
-        }
-
-        return buff_[start_++];
+    // Never splits a frame the presenter thread is writing.
+    static void Write(std::string_view sequence) {
+        tui::utils::WriteTerminal(sequence);
     }
 
-    void Consume() {
-        ++start_;
-    }
-
-    void PutBack() {
-        assert(start_ != 0);
-        --start_;
-    }
-
-    static constexpr int kBuffLen = 64;
-    char buff_[64];
-
-    int start_ = 0;
-    int end_ = 0;
-
+    Parser parser_;
     std::function<void()> on_destroy_;
 };
 
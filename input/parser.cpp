@@ -0,0 +1,195 @@
+#include "parser.h"
+
+#include <array>
+#include <charconv>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace input {
+
+namespace {
+
+constexpr std::string_view kPasteEnd = "\033[201~";
+
+std::optional<Key> Arrow(char final) {
+    switch (final) {
+        case 'A': {
+            return Key::Up;
+        }
+        case 'B': {
+            return Key::Down;
+        }
+        case 'C': {
+            return Key::Right;
+        }
+        case 'D': {
+            return Key::Left;
+        }
+        default: {
+            return std::nullopt;
+        }
+    }
+}
+
+std::optional<Key> Letter(char ch) {
+    switch (ch) {
+        case 'w':
+        case 'W': {
+            return Key::W;
+        }
+        case 'a':
+        case 'A': {
+            return Key::A;
+        }
+        case 's':
+        case 'S': {
+            return Key::S;
+        }
+        case 'd':
+        case 'D': {
+            return Key::D;
+        }
+        case 'j':
+        case 'J': {
+            return Key::J;
+        }
+        case 'u':
+        case 'U': {
+            return Key::U;
+        }
+        default: {
+            return std::nullopt;
+        }
+    }
+}
+
+}  // namespace
+
+std::span<const Event> Parser::Parse(std::span<const char> bytes) {
+    batch_.clear();
+    pasted_.clear();
+    for (auto ch : bytes) {
+        switch (state_) {
+            case State::kGround: {
+                Ground(ch);
+                break;
+            }
+            case State::kEscape: {
+                if (ch == '[') {
+                    params_.clear();
+                    state_ = State::kCsi;
+                } else if (ch == 'O') {
+                    state_ = State::kSs3;
+                } else if (ch != '\033') {
+                    // Alt modified key.
+                    state_ = State::kGround;
+                    Ground(ch);
+                }
+                break;
+            }
+            case State::kCsi: {
+                if (ch >= 0x20 && ch <= 0x3f) {
+                    if (params_.size() <= kMaxParams) {
+                        params_.push_back(ch);
+                    }
+                } else {
+                    state_ = State::kGround;
+                    if (ch >= 0x40 && ch <= 0x7e) {
+                        Csi(ch);
+                    } else {
+                        Ground(ch);
+                    }
+                }
+                break;
+            }
+            case State::kSs3: {
+                state_ = State::kGround;
+                if (auto key = Arrow(ch)) {
+                    Emit({Action::kKeyboard, *key});
+                }
+                break;
+            }
+            case State::kPaste: {
+                Paste(ch);
+                break;
+            }
+        }
+    }
+    return batch_;
+}
+
+void Parser::Ground(char ch) {
+    if (ch == '\033') {
+        state_ = State::kEscape;
+    } else if (auto key = Letter(ch)) {
+        Emit({Action::kKeyboard, *key});
+    }
+}
+
+void Parser::Csi(char final) {
+    if (params_.size() > kMaxParams) {
+        return;
+    }
+    if (auto key = Arrow(final)) {
+        // Modifiers such as "1;5" are ignored.
+        Emit({Action::kKeyboard, *key});
+    } else if (final == '~' && params_ == "200") {
+        paste_.clear();
+        state_ = State::kPaste;
+    } else if ((final == 'M' || final == 'm') && params_.starts_with('<')) {
+        Mouse(final == 'M');
+    }
+}
+
+// SGR report "CSI < button ; column ; row M", or a final 'm' on release.
+void Parser::Mouse(bool press) {
+    std::array<int, 3> values{};
+    const auto* begin = params_.data() + 1;
+    const auto* end = params_.data() + params_.size();
+    for (size_t i = 0; i < values.size(); ++i) {
+        auto [ptr, ec] = std::from_chars(begin, end, values[i]);
+        if (ec != std::errc{} || (i + 1 < values.size() && (ptr == end || *ptr != ';'))) {
+            return;
+        }
+        begin = ptr + 1;
+    }
+    auto button = values[0];
+    constexpr int kMotion = 32;
+    constexpr int kWheel = 64;
+    if (!press || (button & (kMotion | kWheel)) != 0) {
+        return;
+    }
+    if ((button & 3) == 0) {
+        Emit({Action::kMouse, Key::MouseLeft, 1, values[2] - 1, values[1] - 1});
+    } else if ((button & 3) == 2) {
+        Emit({Action::kMouse, Key::MouseRight, 1, values[2] - 1, values[1] - 1});
+    }
+}
+
+void Parser::Paste(char ch) {
+    paste_.push_back(ch);
+    if (!paste_.ends_with(kPasteEnd)) {
+        return;
+    }
+    paste_.resize(paste_.size() - kPasteEnd.size());
+    pasted_.push_back(std::move(paste_));
+    paste_.clear();
+    Emit({.action = Action::kPaste, .key = Key::W, .text = pasted_.back()});
+    state_ = State::kGround;
+}
+
+void Parser::Emit(Event event) {
+    // A held key floods the input with repeats, they are handled as one
+    // event so that the batch costs a single update.
+    if (event.action == Action::kKeyboard && !batch_.empty()) {
+        auto& last = batch_.back();
+        if (last.action == Action::kKeyboard && last.key == event.key) {
+            ++last.repeat;
+            return;
+        }
+    }
+    batch_.push_back(event);
+}
+
+}  // namespace input
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "event.h"
+
+#include <deque>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace input {
+
+// Incremental decoder of terminal input: plain keys, CSI and SS3 escape
+// sequences, SGR mouse reports and bracketed paste. The state is kept
+// between calls, so a sequence may be split across reads.
+class Parser {
+public:
+    // Decodes the bytes of one read, the returned batch stays valid until
+    // the next call.
+    std::span<const Event> Parse(std::span<const char> bytes);
+
+private:
+    enum class State {
+        kGround,
+        kEscape,
+        kCsi,
+        kSs3,
+        kPaste,
+    };
+
+    void Ground(char ch);
+    void Csi(char final);
+    void Mouse(bool press);
+    void Paste(char ch);
+    void Emit(Event event);
+
+    // Longest parameter string kept, longer sequences are dropped.
+    static constexpr size_t kMaxParams = 32;
+
+    State state_ = State::kGround;
+    std::string params_;
+    std::string paste_;
+    // Deque elements stay in place, so events can point into them.
+    std::deque<std::string> pasted_;
+    std::vector<Event> batch_;
+};
+
+}  // namespace input
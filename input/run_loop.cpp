@@ -0,0 +1,137 @@
+#include "run_loop.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace input {
+
+namespace {
+
+constexpr size_t kReadSize = 4096;
+constexpr int kMaxEvents = 4;
+
+void Watch(int epoll_fd, int fd) {
+    epoll_event event{.events = EPOLLIN, .data = {.fd = fd}};
+    auto res = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    assert(res != -1);
+}
+
+sigset_t WinchMask() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGWINCH);
+    return mask;
+}
+
+// Blocked during static initialization, while the process has a single
+// thread, so that every thread inherits the mask and none of them takes
+// the signal before the signalfd. Its default action is to be ignored, so
+// leaving it blocked changes nothing else.
+const bool kWinchBlocked = [] {
+    auto mask = WinchMask();
+    return pthread_sigmask(SIG_BLOCK, &mask, nullptr) == 0;
+}();
+
+}  // namespace
+
+RunLoop::RunLoop(int fps)
+    : frame_period_(std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / fps)
+    , last_frame_(Clock::now() - frame_period_)
+{
+    assert(fps > 0);
+
+    // SIGWINCH is delivered through the signalfd instead of a handler.
+    assert(kWinchBlocked);
+    auto mask = WinchMask();
+    signal_fd_ = signalfd(-1, &mask, SFD_CLOEXEC);
+    assert(signal_fd_ != -1);
+
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    assert(timer_fd_ != -1);
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    assert(epoll_fd_ != -1);
+    Watch(epoll_fd_, STDIN_FILENO);
+    Watch(epoll_fd_, signal_fd_);
+    Watch(epoll_fd_, timer_fd_);
+}
+
+RunLoop::~RunLoop() {
+    close(epoll_fd_);
+    close(timer_fd_);
+    close(signal_fd_);
+}
+
+void RunLoop::Run(const Handlers& handlers) {
+    running_ = true;
+    std::array<epoll_event, kMaxEvents> events;
+    std::array<char, kReadSize> buffer;
+    while (running_) {
+        auto count = epoll_wait(epoll_fd_, events.data(), events.size(), -1);
+        if (count == -1) {
+            assert(errno == EINTR);
+            continue;
+        }
+        for (int i = 0; i < count && running_; ++i) {
+            auto fd = events[i].data.fd;
+            if (fd == STDIN_FILENO) {
+                auto res = read(STDIN_FILENO, buffer.data(), buffer.size());
+                assert(res != -1);
+                if (res == 0) {
+                    // The terminal is gone.
+                    running_ = false;
+                } else if (handlers.on_input) {
+                    handlers.on_input(std::span<const char>(buffer.data(), res));
+                }
+            } else if (fd == signal_fd_) {
+                signalfd_siginfo info;
+                auto res = read(signal_fd_, &info, sizeof(info));
+                assert(res == sizeof(info));
+                if (handlers.on_resize) {
+                    handlers.on_resize();
+                }
+            } else if (fd == timer_fd_) {
+                uint64_t expirations;
+                auto res = read(timer_fd_, &expirations, sizeof(expirations));
+                assert(res == sizeof(expirations));
+                frame_pending_ = false;
+                last_frame_ = Clock::now();
+                if (handlers.on_frame) {
+                    handlers.on_frame();
+                }
+            }
+        }
+    }
+}
+
+void RunLoop::RequestFrame() {
+    if (frame_pending_) {
+        return;
+    }
+    frame_pending_ = true;
+    ArmTimer(std::max(Clock::now(), last_frame_ + frame_period_));
+}
+
+void RunLoop::ArmTimer(Clock::time_point when) {
+    // steady_clock counts CLOCK_MONOTONIC time, like the timer.
+    auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+    constexpr int64_t kNanosPerSecond = 1'000'000'000;
+    itimerspec spec{};
+    spec.it_value.tv_sec = since_epoch / kNanosPerSecond;
+    spec.it_value.tv_nsec = since_epoch % kNanosPerSecond;
+    // A zero value would disarm the timer instead.
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+        spec.it_value.tv_nsec = 1;
+    }
+    auto res = timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+    assert(res != -1);
+}
+
+}  // namespace input
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <signal.h>
+#include <span>
+
+namespace input {
+
+// Blocks in epoll on stdin, terminal resizes and a frame timer, so an idle
+// application wakes up only when there is something to do.
+class RunLoop {
+public:
+    struct Handlers {
+        // Everything that was pending on stdin, read at once.
+        std::function<void(std::span<const char>)> on_input;
+        std::function<void()> on_resize;
+        std::function<void()> on_frame;
+    };
+
+    // Frames are paced to at most `fps` per second. SIGWINCH is blocked in
+    // every thread from program start on and only ever read from the loop,
+    // so threads may be started before or after it.
+    explicit RunLoop(int fps);
+    ~RunLoop();
+
+    RunLoop(const RunLoop&) = delete;
+    RunLoop& operator=(const RunLoop&) = delete;
+
+    // Dispatches events until Stop() is called from one of the handlers.
+    void Run(const Handlers& handlers);
+
+    void Stop() {
+        running_ = false;
+    }
+
+    // Schedules on_frame at the earliest moment the pacing allows, requests
+    // made before it runs are merged into one frame.
+    void RequestFrame();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void ArmTimer(Clock::time_point when);
+
+    int epoll_fd_;
+    int signal_fd_;
+    int timer_fd_;
+
+    Clock::duration frame_period_;
+    Clock::time_point last_frame_;
+    bool frame_pending_ = false;
+    bool running_ = false;
+};
+
+}  // namespace input
@@ -1,15 +1,26 @@
 #include "braille/canvas.h"
+#include "graphics/mesh.h"
 #include "graphics/renderer.h"
+#include "graphics/resolve.h"
 #include "input/input.h"
+#include "input/run_loop.h"
+#include "tui/frame_arena.h"
 #include "tui/plates.h"
 #include "tui/utils.h"
 #include "tui/view_port.h"
 #include "math/3d.h"
+#include "math/frustum.h"
+#include "math/transform.h"
+#include "voxel/world.h"
 
 #include <cstring>
+#include <algorithm>
 #include <complex>
 #include <iostream>
 #include <iomanip>
+#include <memory_resource>
+#include <span>
+#include <thread>
 #include <unistd.h>
 #include "fcntl.h"
 #include "tui/utf8.h"
@@ -36,76 +47,52 @@ void Draw(graphics::Renderer& renderer, math::Vec4 first, math::Vec4 second, tui
     renderer.DrawSegment(f, s, tui::Color::kWhite);
 }
 
-class SquarePolytexture : public graphics::Polytexture {
+// Draws a square inset into every unit tile of a quad spanning `extent` tiles.
+class SquarePolytexture {
 public:
-    SquarePolytexture(tui::Color inner)
+    struct TriTexture {
+        tui::Color inner;
+        math::Vec2 a;
+        math::Vec2 b;
+        math::Vec2 c;
+
+        tui::Color Get(const math::Vec3& bary) const {
+            auto uv = a * bary.x + b * bary.y + c * bary.z;
+            auto u = uv.x - std::floor(uv.x);
+            auto v = uv.y - std::floor(uv.y);
+            return u > 0.2 && u < 0.8 && v > 0.2 && v < 0.8 ? inner : tui::Color::kDefault;
+        }
+    };
+
+    SquarePolytexture(tui::Color inner, math::Vec2 extent = {1.0, 1.0})
         : inner_(inner)
+        , extent_(extent)
     {
     }
 
-    std::unique_ptr<graphics::Texture> Get(size_t i, size_t j, size_t k) const override {
-        math::Vec3 bounds{0.2, 0.2, -0.1};
-        if ((i ^ j) % 2) {
-            std::swap(j, k);
-            std::swap(bounds.y, bounds.z);
-        }
-        if ((i ^ j) % 2) {
-            std::swap(i, k);
-            std::swap(bounds.x, bounds.z);
-        }
-        return std::make_unique<TriTexture>(inner_, bounds);
+    TriTexture Get(size_t i, size_t j, size_t k) const {
+        return {.inner = inner_, .a = Corner(i), .b = Corner(j), .c = Corner(k)};
     }
 
 private:
-    class TriTexture : public graphics::Texture {
-    public:
-        TriTexture(tui::Color inner, math::Vec3 bounds)
-            : inner_(inner)
-            , bounds_(bounds)
-        {
-        }
-
-        tui::Color Get(const math::Vec3& bary) const override {
-            return bary.x > bounds_.x && bary.y > bounds_.y && bary.z > bounds_.z ? inner_ : tui::Color::kDefault;
-            // return tui::Color::kDefault;
-        }
-
-    private:
-        tui::Color inner_;
-        math::Vec3 bounds_;
-    };
+    math::Vec2 Corner(size_t i) const {
+        assert(i < 4);
+        return {
+            .x = (i == 1 || i == 2) ? extent_.x : 0,
+            .y = (i == 2 || i == 3) ? extent_.y : 0,
+        };
+    }
 
     tui::Color inner_;
+    math::Vec2 extent_;
 };
 
 void DrawPolygon(graphics::Renderer& renderer, const std::vector<math::Vec4>& points, const math::Mat4& mvp, tui::Color outer, const graphics::Polytexture& texture) {
-    std::vector<math::Vec4> input;
-    for (auto& pt : points) {
-        input.push_back((mvp * pt));
-    }
+    std::vector<math::Vec4> input(points.size());
+    math::Transform(mvp, points, input);
     renderer.DrawPolygon(input, outer, texture);
 }
 
-void TransferToCanvas(const graphics::Renderer& renderer, braille::Canvas& canvas) {
-    assert(renderer.Width() == 2 * canvas.Width());
-    assert(renderer.Height() == 4 * canvas.Height());
-
-    for (int i = 0; i < renderer.Height(); ++i) {
-        for (int j = 0; j < renderer.Width(); ++j) {
-            if (renderer.Get(i, j).Defined()) {
-                canvas.Set(i, j, renderer.Get(i, j).Defined());
-            }
-        }
-    }
-
-    auto colormap = renderer.BuildDownsampledColormap(4, 2);
-    for (int i = 0; i < colormap.size(); ++i) {
-        for (int j = 0; j < colormap.at(0).size(); ++j) {
-            canvas.SetColor(i, j, colormap.at(i).at(j));
-        }
-    }
-}
-
 class ExampleTexture : public graphics::Polytexture {
 public:
     std::unique_ptr<graphics::Texture> Get(size_t i, size_t j, size_t k) const override {
@@ -157,9 +144,8 @@ private:
                 }
                 return std::abs(z) < 2;
             };
-            int quad_i = 5;
-            int quad_j = (2 * posx + posy + 3) * 6 / 6;
-            auto color = static_cast<tui::Color>(16 + 6 * quad_j + quad_i);
+            auto shade = std::clamp((2 * posx + posy + 3) / 6, 0.0f, 1.0f);
+            auto color = tui::MakeRgb(0, 255 * shade, 255);
             return (lies(posx, posy)) ? color : tui::Color::kDefault;
         }
 
@@ -169,6 +155,7 @@ private:
 
 void Example() {
     tui::ViewPort view(30, 60);
+    view.SetColorMode(tui::utils::DetectColorMode());
     /*
     view.PlaceObject(-8, 40, tui::Border(20, 60, tui::Color::kBlue));
     view.PlaceObject(0, 0, tui::Border(20, 60, tui::Color::kGreen));
@@ -243,7 +230,7 @@ void Example() {
     }
     */
     renderer.DrawPolygon({vec(2), vec(0), vec(1), vec(3)}, tui::Color::kYellow, ExampleTexture());
-    TransferToCanvas(renderer, canvas);
+    graphics::Resolve(renderer, canvas);
     view.PlaceObject(0, 0, tui::Border(view.Height(), view.Width(), tui::Color::kWhite));
     view.PlaceObject(1, 1, canvas);
     view.Render(true);
@@ -252,219 +239,179 @@ void Example() {
     std::cin >> a;
 }
 
-bool world[20][20][20] = {};
+voxel::World world(20, 20, 20, tui::Color::kYellow);
 math::Vec3 camPos = {1.0, 2.7, 1.0};
 math::Vec4 direction = {-1.0, -0.7, -1.0, 1.0};
 
-void RenderTo(graphics::Renderer& renderer, const math::Mat4& mvp, bool cool_colors, std::vector<int> block_s_podvohom = {}) {
-    for (int layer = 1; layer < 19; ++layer) {
-        for (int x = 1; x < 19; ++x) {
-            for (int z = 1; z < 19; ++z) {
-                if (!world[layer][x][z]) {
-                    continue;
-                }
-                auto vec = [=](uint8_t code) {
-                    math::Vec4 result{};
-                    double scale = 0.2;
-                    if (code & 1) {
-                        result[0] = scale;
-                    }
-                    if (code & 2) {
-                        result[1] = scale;
-                    }
-                    if (code & 4) {
-                        result[2] = scale;
-                    }
-                    result[0] += scale * x;
-                    result[1] += scale * layer;
-                    result[2] += scale * z;
-                    result[3] = 1.0;
-                    return result;
-                };
-                for (uint8_t i = 0; i < 8; ++i) {
-                    for (auto mask : {std::pair{1, 2}, std::pair{2, 4}, std::pair{4, 1}}) {
-                        if ((i ^ mask.first ^ mask.second) < i || (i ^ mask.first) < i || (i ^ mask.second) < i) {
-                            continue;
-                        }
-                        auto color = tui::Color::kYellow;
-                        if (cool_colors) {
-                            uint32_t code = x | (layer << 8) | (z << 16);
-                            uint32_t dir = 7 ^ mask.first ^ mask.second;
-                            if (i & dir) {
-                                dir |= 8;
-                            }
-                            code |= (dir << 24);
-                            color = static_cast<tui::Color>(code);
-                            // std::wcerr << " " << code << "         " << std::endl;
-                        }
-                        auto outer = tui::Color::kDefault;
-                        if (!block_s_podvohom.empty()) {
-                            if (block_s_podvohom[0] == x && block_s_podvohom[1] == layer && block_s_podvohom[2] == z) {
-                                outer = tui::Color::kRed;
-                            }
-                        }
-                        if (cool_colors) {
-                            outer = color;
-                        }
-                        auto t1 = graphics::SolidPolytexture(color);
-                        auto t2 = SquarePolytexture(color);
-                        if (cool_colors) {
-                            DrawPolygon(renderer, {
-                                vec(i),
-                                vec(i ^ mask.first),
-                                vec(i ^ mask.first ^ mask.second),
-                                vec(i ^ mask.second),
-                            // }, tui::Color::kDefault, static_cast<tui::Color>(i * 10 + mask.first));
-                            }, mvp, outer, t1);
-                        } else {
-                            DrawPolygon(renderer, {
-                                vec(i),
-                                vec(i ^ mask.first),
-                                vec(i ^ mask.first ^ mask.second),
-                                vec(i ^ mask.second),
-                            // }, tui::Color::kDefault, static_cast<tui::Color>(i * 10 + mask.first));
-                            }, mvp, outer, t2);
-                        }
-                    }
-                }
-                if (cool_colors) {
-                    continue;
-                }
-                for (uint8_t i = 0; i < 8; ++i) {
-                    if ((i ^ 1) > i) {
-                        auto other_x = x;
-                        // auto other_x = z + (i & 1 ? 1 : -1);
-                        auto other_y = layer + (i & 2 ? 1 : -1);
-                        auto other_z = z + (i & 4 ? 1 : -1);
-                        if (world[other_y][other_x][other_z] || !(world[other_y][other_x][z] ^ world[layer][other_x][other_z])) {
-                            Draw(renderer, vec(i), vec(i ^ 1), static_cast<tui::Color>(i + 1));
-                        }
-                    }
-                    if ((i ^ 2) > i) {
-                        auto other_x = x + (i & 1 ? 1 : -1);
-                        auto other_y = layer;
-                        auto other_z = z + (i & 4 ? 1 : -1);
-                        if (world[other_y][other_x][other_z] || !(world[other_y][other_x][z] ^ world[other_y][x][other_z])) {
-                            Draw(renderer, vec(i), vec(i ^ 2), static_cast<tui::Color>(i + 1));
-                        }
-                    }
-                    if ((i ^ 4) > i) {
-                        auto other_x = x + (i & 1 ? 1 : -1);
-                        auto other_y = layer + (i & 2 ? 1 : -1);
-                        auto other_z = z;
-                        if (world[other_y][other_x][other_z] || !(world[layer][other_x][other_z] ^ world[other_y][x][other_z])) {
-                            Draw(renderer, vec(i), vec(i ^ 4), static_cast<tui::Color>(i + 1));
-                        }
-                    }
-                }
+constexpr float kBlockSize = 0.2;
+
+graphics::VertexCache vertex_cache;
+
+void DrawBlockOutline(graphics::Renderer& renderer, const math::Mat4& mvp, int x, int y, int z, tui::Color color) {
+    auto corner = [&](uint8_t i) {
+        return mvp * math::Vec4{
+            static_cast<float>(x + (i & 1 ? 1 : 0)),
+            static_cast<float>(y + (i & 2 ? 1 : 0)),
+            static_cast<float>(z + (i & 4 ? 1 : 0)),
+            1.0,
+        };
+    };
+    for (uint8_t i = 0; i < 8; ++i) {
+        for (uint8_t axis : {1, 2, 4}) {
+            if ((i ^ axis) > i) {
+                renderer.DrawSegment(corner(i), corner(i ^ axis), color);
             }
         }
     }
 }
 
+std::optional<voxel::World::Hit> PickBlock() {
+    return world.Raycast(1 / kBlockSize * camPos, math::FromProjective(direction), 100.0 / kBlockSize);
+}
+
+void RenderTo(graphics::Renderer& renderer, const math::Mat4& mvp, std::optional<voxel::World::Hit> highlight, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    auto model = mvp * math::Scale({kBlockSize, kBlockSize, kBlockSize});
+
+    math::Frustum frustum(model);
+    for (int chunk : world.ChunksFrontToBack(1 / kBlockSize * camPos, resource)) {
+        if (!frustum.Intersects(world.ChunkBounds(chunk))) {
+            continue;
+        }
+        const auto& chunk_mesh = world.ChunkMesh(chunk);
+        vertex_cache.Transform(model, chunk_mesh);
+        for (const auto& face : chunk_mesh.Faces()) {
+            renderer.DrawPolygon(vertex_cache, chunk_mesh.Corners(face), face.outer, SquarePolytexture(face.fill, face.extent));
+        }
+        for (const auto& edge : chunk_mesh.Edges()) {
+            renderer.DrawSegment(vertex_cache, edge.a, edge.b, edge.color);
+        }
+    }
+    if (highlight) {
+        DrawBlockOutline(renderer, model, highlight->x, highlight->y, highlight->z, tui::Color::kRed);
+    }
+}
+
+// The view fills the terminal except for the last line, which would scroll
+// the screen. Without a terminal it keeps a fixed size.
+tui::utils::Dims ViewSize(tui::utils::Dims screen) {
+    if (screen.x == 0 || screen.y == 0) {
+        return {.x = 119, .y = 59};
+    }
+    return {.x = std::max(screen.x, 3), .y = std::max(screen.y - 1, 3)};
+}
+
 int main() {
     Example();
     // return 0;
-    tui::ViewPort view(59, 119);
+    input::RunLoop loop(30);
+    auto size = ViewSize(tui::utils::GetScreenDimensions());
+    tui::ViewPort view(size.y, size.x);
+    // Temporaries of a frame, reset once it is out.
+    tui::FrameArena arena;
+    view.SetFrameResource(&arena);
+    view.SetColorMode(tui::utils::DetectColorMode());
     view.Clear();
     view.PlaceObject(0, 0, tui::Border(view.Height(), view.Width(), tui::Color::kGreen));
 
-    world[10][10][10] = true;
+    world.Set(10, 10, 10, true);
     input::EventPoller poller;
-    for (double angle = 0; ; angle += 0.05) {
-        bool got_event = false;
-        bool will_place = false;
-        bool will_destroy = false;
-        while (auto event = poller.Poll()) {
-            got_event = true;
-            math::Vec3 up = {0.0, 1.0, 0.0};
-            math::Vec3 left = 0.1 * math::Vec3::Cross(math::FromProjective(direction), up);
-            math::Vec3 forward = math::Vec3::Cross(up, left);
-            if (event->key == input::Key::W) {
-                camPos += forward;
-            }
-            if (event->key == input::Key::S) {
-                camPos += -forward;
-            }
-            if (event->key == input::Key::A) {
-                camPos += left;
+    // With coverage a pixel spans 2x2 braille dots, one per sample.
+    graphics::Renderer renderer(view.Height() * 2 - 4, view.Width() - 2);
+    renderer.EnableBinning(std::thread::hardware_concurrency());
+    renderer.EnableCoverage(true);
+    braille::Canvas canvas(renderer.Height() * 2, renderer.Width() * 2);
+    bool will_place = false;
+    bool will_destroy = false;
+    auto on_input = [&](std::span<const char> bytes) {
+        for (const auto& event : poller.Feed(bytes)) {
+            if (event.action == input::Action::kPaste) {
+                continue;
             }
-            if (event->key == input::Key::D) {
-                camPos += -left;
-            }
-            if (event->key == input::Key::J) {
-                will_place = true;
-            }
-            if (event->key == input::Key::U) {
+            if (event.key == input::Key::MouseLeft) {
                 will_destroy = true;
             }
-            if (event->key == input::Key::Up) {
-                // assert(false);
-                direction = math::Rotate(M_PI / 30, math::Vec3::Cross(math::FromProjective(direction), {0.0, 1.0, 0.0})) * direction;
-            }
-            if (event->key == input::Key::Down) {
-                // assert(false);
-                direction = math::Rotate(-M_PI / 30, math::Vec3::Cross(math::FromProjective(direction), {0.0, 1.0, 0.0})) * direction;
-            }
-            if (event->key == input::Key::Left) {
-                // assert(false);
-                direction = math::Rotate(M_PI / 30, {0.0, 1.0, 0.0}) * direction;
+            if (event.key == input::Key::MouseRight) {
+                will_place = true;
             }
-            if (event->key == input::Key::Right) {
-                // assert(false);
-                direction = math::Rotate(-M_PI / 30, {0.0, 1.0, 0.0}) * direction;
+            for (int i = 0; i < event.repeat; ++i) {
+                math::Vec3 up = {0.0, 1.0, 0.0};
+                math::Vec3 left = 0.1 * math::Vec3::Cross(math::FromProjective(direction), up);
+                math::Vec3 forward = math::Vec3::Cross(up, left);
+                if (event.key == input::Key::W) {
+                    camPos += forward;
+                }
+                if (event.key == input::Key::S) {
+                    camPos += -forward;
+                }
+                if (event.key == input::Key::A) {
+                    camPos += left;
+                }
+                if (event.key == input::Key::D) {
+                    camPos += -left;
+                }
+                if (event.key == input::Key::J) {
+                    will_place = true;
+                }
+                if (event.key == input::Key::U) {
+                    will_destroy = true;
+                }
+                if (event.key == input::Key::Up) {
+                    // assert(false);
+                    direction = math::Rotate(M_PI / 30, math::Vec3::Cross(math::FromProjective(direction), {0.0, 1.0, 0.0})) * direction;
+                }
+                if (event.key == input::Key::Down) {
+                    // assert(false);
+                    direction = math::Rotate(-M_PI / 30, math::Vec3::Cross(math::FromProjective(direction), {0.0, 1.0, 0.0})) * direction;
+                }
+                if (event.key == input::Key::Right) {
+                    // assert(false);
+                    direction = math::Rotate(M_PI / 30, {0.0, 1.0, 0.0}) * direction;
+                }
+                if (event.key == input::Key::Left) {
+                    // assert(false);
+                    direction = math::Rotate(-M_PI / 30, {0.0, 1.0, 0.0}) * direction;
+                }
             }
         }
-        if (!got_event) {
-            usleep(10000);
-            continue;
-        }
-
+        loop.RequestFrame();
+    };
+    auto on_resize = [&] {
+        view.RefreshScreenDimensions();
+        auto size = ViewSize(view.ScreenDimensions());
+        view.Resize(size.y, size.x);
+        renderer.Resize(view.Height() * 2 - 4, view.Width() - 2);
+        canvas.Resize(renderer.Height() * 2, renderer.Width() * 2);
+        view.Clear();
+        view.PlaceObject(0, 0, tui::Border(view.Height(), view.Width(), tui::Color::kGreen));
+        loop.RequestFrame();
+    };
+    auto on_frame = [&] {
         direction.Normalize();
-        graphics::Renderer renderer(view.Height() * 4 - 8, view.Width() * 2 - 4);
-        graphics::Renderer renderer2(view.Height() * 4 - 8, view.Width() * 2 - 4);
+        renderer.Clear();
         mvp = math::Perspective(M_PI / 2.5, 1, 0.1, 100.0) * math::LookAt(camPos, camPos + math::FromProjective(direction), {0.0, -1.0, 0.0});
-        RenderTo(renderer2, mvp, true);
-        uint32_t code = static_cast<uint32_t>(renderer2.Get(renderer2.Height() / 2, renderer2.Width() / 2).color);
-        auto x = code & 0xff;
-        auto y = (code & 0xff00) >> 8;
-        auto z = (code & 0xff0000) >> 16;
-        auto dir = (code & 0xff000000) >> 24;
-        if (will_place) {
-            auto mult = dir < 8 ? -1 : 1;
-            dir &= 7;
-            if (dir == 1) {
-                x += mult;
-            } else if (dir == 2) {
-                y += mult;
-            } else if (dir == 4) {
-                z += mult;
-            }
-            world[y][x][z] = true;
+        auto hit = PickBlock();
+        if (hit && will_place) {
+            world.Set(hit->x + hit->nx, hit->y + hit->ny, hit->z + hit->nz, true);
+            hit = PickBlock();
         }
-        if (will_destroy) {
-            world[y][x][z] = false;
-            graphics::Renderer renderer2(view.Height() * 4 - 8, view.Width() * 2 - 4);
-            RenderTo(renderer2, mvp, true);
-            uint32_t code = static_cast<uint32_t>(renderer2.Get(renderer2.Height() / 2, renderer2.Width() / 2).color);
-            x = code & 0xff;
-            y = (code & 0xff00) >> 8;
-            z = (code & 0xff0000) >> 16;
-            dir = (code & 0xff000000) >> 24;
+        if (hit && will_destroy) {
+            world.Set(hit->x, hit->y, hit->z, false);
+            hit = PickBlock();
         }
-        RenderTo(renderer, mvp, false, {x, y, z});
+        will_place = false;
+        will_destroy = false;
+        RenderTo(renderer, mvp, hit, &arena);
+        renderer.Flush();
         // Draw(renderer, vec(0), vec(1), tui::Color::kWhite);
         // renderer.DrawTriangle({0.0, 0.7}, {0.7, 0.0}, {-0.7, 0.0});
         // renderer.DrawSegment({0.0, 0.7}, {0.7, 0.0}, tui::Color::kWhite);
-        braille::Canvas canvas(renderer.Height(), renderer.Width());
-        TransferToCanvas(renderer, canvas);
+        graphics::Resolve(renderer, canvas);
         view.PlaceObject(1, 1, canvas);
         view.PlaceObject(view.Height() / 2, view.Width() / 2, tui::Textbox("x", tui::Color::kRed));
         view.Render(false);
-        std::wcerr << x << "\t\n" << y << "\t\n" << z << "          " << std::endl;
-        mvp = mvp * math::Rotate(M_PI / 20, {0.4, 0.4, 0.4});
-        usleep(50000);
-        // usleep(1000000);
-    }
+        arena.Reset();
+    };
+    loop.RequestFrame();
+    loop.Run({.on_input = on_input, .on_resize = on_resize, .on_frame = on_frame});
 }
 
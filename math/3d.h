@@ -65,6 +65,14 @@ inline Mat4 Rotate(float angle, Vec3 v) {
     return rotate;
 }
 
+inline Mat4 Scale(Vec3 v) {
+    Mat4 scale = IdentityMat4();
+    scale[0][0] = v.x;
+    scale[1][1] = v.y;
+    scale[2][2] = v.z;
+    return scale;
+}
+
 inline Vec3 FromProjective(const Vec4& vec) {
     return {
         vec[0] / vec[3],
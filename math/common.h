@@ -4,6 +4,10 @@
 #include <cassert>
 #include <cmath>
 
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
 namespace math {
 
 struct Vec4 {
@@ -238,25 +242,46 @@ inline auto IdentityMat4() {
 
 inline math::Mat4 operator*(const math::Mat4& a, const math::Mat4& b) {
     math::Mat4 result;
+#if defined(__SSE__)
+    // Row i of the product is the combination of the rows of b weighted by a[i].
+    auto b0 = _mm_loadu_ps(b[0].data());
+    auto b1 = _mm_loadu_ps(b[1].data());
+    auto b2 = _mm_loadu_ps(b[2].data());
+    auto b3 = _mm_loadu_ps(b[3].data());
+    for (int i = 0; i < 4; ++i) {
+        auto row = _mm_mul_ps(_mm_set1_ps(a[i][0]), b0);
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i][1]), b1));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i][2]), b2));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i][3]), b3));
+        _mm_storeu_ps(result[i].data(), row);
+    }
+#else
     for (int i = 0; i < 4; ++i) {
         for (int j = 0; j < 4; ++j) {
-            result[i][j] = 0.0;
-            for (int k = 0; k < 4; ++k) {
-                result[i][j] += a[i][k] * b[k][j];
-            }
+            result[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j] + a[i][3] * b[3][j];
         }
     }
+#endif
     return result;
 }
 
 inline math::Vec4 operator*(const math::Mat4& a, const math::Vec4& x) {
-    math::Vec4 result = {};
-    for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 4; ++j) {
-            result[i] += a[i][j] * x[j];
-        }
-    }
+#if defined(__SSE__)
+    auto v = _mm_loadu_ps(&x.x);
+    auto r0 = _mm_mul_ps(_mm_loadu_ps(a[0].data()), v);
+    auto r1 = _mm_mul_ps(_mm_loadu_ps(a[1].data()), v);
+    auto r2 = _mm_mul_ps(_mm_loadu_ps(a[2].data()), v);
+    auto r3 = _mm_mul_ps(_mm_loadu_ps(a[3].data()), v);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    math::Vec4 result;
+    _mm_storeu_ps(&result.x, _mm_add_ps(_mm_add_ps(r0, r1), _mm_add_ps(r2, r3)));
     return result;
+#else
+    auto row = [&](int i) {
+        return a[i][0] * x.x + a[i][1] * x.y + a[i][2] * x.z + a[i][3] * x.w;
+    };
+    return {row(0), row(1), row(2), row(3)};
+#endif
 }
 
 inline math::Vec3 operator*(float f, const math::Vec3& x) {
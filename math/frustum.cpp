@@ -0,0 +1,49 @@
+#include "frustum.h"
+
+#include <cmath>
+
+namespace math {
+
+Frustum::Frustum(const Mat4& mvp) {
+    // Each clip inequality, e.g. x >= -w, is linear in the input point with
+    // the coefficients being a sum or difference of two matrix rows.
+    auto row = [&](int i) {
+        return Vec4{mvp[i][0], mvp[i][1], mvp[i][2], mvp[i][3]};
+    };
+    for (int axis = 0; axis < 3; ++axis) {
+        planes_[2 * axis] = row(3) + row(axis);
+        planes_[2 * axis + 1] = row(3) - row(axis);
+    }
+    for (auto& plane : planes_) {
+        auto length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0) {
+            plane = (1 / length) * plane;
+        }
+    }
+}
+
+bool Frustum::Intersects(const Box& box) const {
+    for (const auto& plane : planes_) {
+        // The corner furthest along the plane normal.
+        Vec3 corner{
+            plane.x >= 0 ? box.max.x : box.min.x,
+            plane.y >= 0 ? box.max.y : box.min.y,
+            plane.z >= 0 ? box.max.z : box.min.z,
+        };
+        if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::Intersects(Vec3 center, float radius) const {
+    for (const auto& plane : planes_) {
+        if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace math
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "common.h"
+
+#include <array>
+
+namespace math {
+
+// Axis-aligned box given by its minimal and maximal corners.
+struct Box {
+    Vec3 min;
+    Vec3 max;
+};
+
+// The clip volume -w <= x, y, z <= w of a projection matrix, expressed as
+// six planes in the space the matrix is applied to. The tests are
+// conservative: false means the volume is certainly outside.
+class Frustum {
+public:
+    explicit Frustum(const Mat4& mvp);
+
+    bool Intersects(const Box& box) const;
+
+    bool Intersects(Vec3 center, float radius) const;
+
+private:
+    // Normalized planes a * x + b * y + c * z + d >= 0 stored as (a, b, c, d).
+    std::array<Vec4, 6> planes_;
+};
+
+}  // namespace math
@@ -0,0 +1,86 @@
+#include "transform.h"
+
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+namespace math {
+
+namespace {
+
+#if defined(__SSE__)
+
+struct Columns {
+    __m128 x;
+    __m128 y;
+    __m128 z;
+    __m128 w;
+};
+
+Columns LoadColumns(const Mat4& mat) {
+    Columns cols{
+        .x = _mm_loadu_ps(mat[0].data()),
+        .y = _mm_loadu_ps(mat[1].data()),
+        .z = _mm_loadu_ps(mat[2].data()),
+        .w = _mm_loadu_ps(mat[3].data()),
+    };
+    _MM_TRANSPOSE4_PS(cols.x, cols.y, cols.z, cols.w);
+    return cols;
+}
+
+void TransformOne(const Columns& cols, const Vec4& in, Vec4& out) {
+    auto v = _mm_loadu_ps(&in.x);
+    auto result = _mm_mul_ps(cols.x, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+    result = _mm_add_ps(result, _mm_mul_ps(cols.y, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    result = _mm_add_ps(result, _mm_mul_ps(cols.z, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+    result = _mm_add_ps(result, _mm_mul_ps(cols.w, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+    _mm_storeu_ps(&out.x, result);
+}
+
+#endif
+
+#if defined(__AVX__)
+
+// Transforms two vectors per iteration, one per 128-bit lane.
+size_t TransformPairs(const Columns& cols, std::span<const Vec4> in, std::span<Vec4> out) {
+    auto x = _mm256_set_m128(cols.x, cols.x);
+    auto y = _mm256_set_m128(cols.y, cols.y);
+    auto z = _mm256_set_m128(cols.z, cols.z);
+    auto w = _mm256_set_m128(cols.w, cols.w);
+
+    size_t i = 0;
+    for (; i + 2 <= in.size(); i += 2) {
+        auto v = _mm256_loadu_ps(&in[i].x);
+        auto result = _mm256_mul_ps(x, _mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0)));
+        result = _mm256_add_ps(result, _mm256_mul_ps(y, _mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1))));
+        result = _mm256_add_ps(result, _mm256_mul_ps(z, _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2))));
+        result = _mm256_add_ps(result, _mm256_mul_ps(w, _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3))));
+        _mm256_storeu_ps(&out[i].x, result);
+    }
+    return i;
+}
+
+#endif
+
+}  // namespace
+
+void Transform(const Mat4& mat, std::span<const Vec4> in, std::span<Vec4> out) {
+    assert(out.size() >= in.size());
+
+#if defined(__SSE__)
+    auto cols = LoadColumns(mat);
+    size_t i = 0;
+#if defined(__AVX__)
+    i = TransformPairs(cols, in, out);
+#endif
+    for (; i < in.size(); ++i) {
+        TransformOne(cols, in[i], out[i]);
+    }
+#else
+    for (size_t i = 0; i < in.size(); ++i) {
+        out[i] = mat * in[i];
+    }
+#endif
+}
+
+}  // namespace math
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "common.h"
+
+#include <span>
+
+namespace math {
+
+// Writes `mat * in[i]` to `out[i]` for every vector of `in`.
+// `out` must be at least as long as `in` and may alias it exactly.
+void Transform(const Mat4& mat, std::span<const Vec4> in, std::span<Vec4> out);
+
+}  // namespace math
@@ -0,0 +1,163 @@
+#include "ansi.h"
+#include "utf8.h"
+
+#include <array>
+#include <cassert>
+
+namespace tui::ansi {
+
+namespace {
+
+struct Sequence {
+    std::array<char, 12> bytes = {};
+    uint8_t size = 0;
+
+    constexpr void Push(char ch) {
+        bytes[size++] = ch;
+    }
+
+    constexpr void Push(const char* str) {
+        for (; *str; ++str) {
+            Push(*str);
+        }
+    }
+
+    constexpr void PushInt(int value) {
+        if (value >= 100) {
+            Push('0' + value / 100);
+        }
+        if (value >= 10) {
+            Push('0' + value / 10 % 10);
+        }
+        Push('0' + value % 10);
+    }
+};
+
+struct Tables {
+    // Index 256 holds the sequence for Color::kDefault.
+    std::array<Sequence, 257> fg;
+    std::array<Sequence, 257> bg;
+    // Two ASCII digits for every number below 100.
+    std::array<char, 200> digits;
+    // ";N" for every byte value, the tail of a truecolor sequence.
+    std::array<Sequence, 256> channels;
+};
+
+constexpr Sequence BuildColor(const char* prefix, int color) {
+    Sequence seq;
+    seq.Push("\033[");
+    seq.Push(prefix);
+    seq.PushInt(color);
+    seq.Push('m');
+    return seq;
+}
+
+constexpr Tables BuildTables() {
+    Tables tables;
+    for (int i = 0; i < 256; ++i) {
+        tables.fg[i] = BuildColor("38;5;", i);
+        tables.bg[i] = BuildColor("48;5;", i);
+    }
+    tables.fg[256].Push("\033[39m");
+    tables.bg[256].Push("\033[49m");
+    for (int i = 0; i < 100; ++i) {
+        tables.digits[2 * i] = '0' + i / 10;
+        tables.digits[2 * i + 1] = '0' + i % 10;
+    }
+    for (int i = 0; i < 256; ++i) {
+        tables.channels[i].Push(';');
+        tables.channels[i].PushInt(i);
+    }
+    return tables;
+}
+
+constexpr Tables kTables = BuildTables();
+
+void Put(OutputBuffer& out, const Sequence& seq) {
+    out.Append(seq.bytes.data(), seq.size);
+}
+
+void PutColor(OutputBuffer& out, const std::array<Sequence, 257>& table, const char* truecolor,
+        Color color, ColorMode mode) {
+    if (color == Color::kDefault) {
+        Put(out, table[256]);
+        return;
+    }
+    if (IsRgb(color) && mode == ColorMode::kTrueColor) {
+        auto rgb = ToRgb(color);
+        out.Append(truecolor, 6);
+        Put(out, kTables.channels[rgb.r]);
+        Put(out, kTables.channels[rgb.g]);
+        Put(out, kTables.channels[rgb.b]);
+        out.Append("m", 1);
+        return;
+    }
+    color = ToPalette(color);
+    // Anything else, like kTransparent, falls back to the default color.
+    const auto& seq = IsPalette(color) ? table[static_cast<int>(color)] : table[256];
+    assert((IsPalette(color) || color == Color::kTransparent) && "not a palette color");
+    Put(out, seq);
+}
+
+// Writes a non-negative number below 10000 and returns its length.
+size_t FormatInt(char* out, int value) {
+    assert(value >= 0 && value < 10000);
+    if (value < 10) {
+        out[0] = '0' + value;
+        return 1;
+    }
+    if (value < 100) {
+        std::memcpy(out, &kTables.digits[2 * value], 2);
+        return 2;
+    }
+    if (value < 1000) {
+        out[0] = '0' + value / 100;
+        std::memcpy(out + 1, &kTables.digits[2 * (value % 100)], 2);
+        return 3;
+    }
+    std::memcpy(out, &kTables.digits[2 * (value / 100)], 2);
+    std::memcpy(out + 2, &kTables.digits[2 * (value % 100)], 2);
+    return 4;
+}
+
+}  // namespace
+
+void SetForegroundColor(OutputBuffer& out, Color color, ColorMode mode) {
+    PutColor(out, kTables.fg, "\033[38;2", color, mode);
+}
+
+void SetBackgroundColor(OutputBuffer& out, Color color, ColorMode mode) {
+    PutColor(out, kTables.bg, "\033[48;2", color, mode);
+}
+
+void MoveCursor(OutputBuffer& out, int y, int x) {
+    auto* begin = out.Reserve(12);
+    auto* caret = begin;
+    *caret++ = '\033';
+    *caret++ = '[';
+    caret += FormatInt(caret, y + 1);
+    *caret++ = ';';
+    caret += FormatInt(caret, x + 1);
+    *caret++ = 'H';
+    out.Commit(caret - begin);
+}
+
+void ResetCursor(OutputBuffer& out) {
+    out.Append("\033[H", 3);
+}
+
+void ClearScreen(OutputBuffer& out) {
+    out.Append("\033[2J", 4);
+    ResetCursor(out);
+}
+
+void PutChar(OutputBuffer& out, uint32_t unicode) {
+    if (unicode < 0x80) {
+        *out.Reserve(1) = unicode;
+        out.Commit(1);
+        return;
+    }
+    out.Commit(Utf8Encode(out.Reserve(5), unicode));
+}
+
+}  // namespace tui::ansi
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "color.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace tui {
+
+// Growable byte buffer for terminal output. Writes always go through
+// Reserve(), so it can never overflow.
+class OutputBuffer {
+public:
+    void Clear() {
+        size_ = 0;
+    }
+
+    const char* Data() const {
+        return data_.data();
+    }
+
+    size_t Size() const {
+        return size_;
+    }
+
+    // Makes room for at least `n` more bytes and returns where they start.
+    // Nothing is appended until Commit().
+    char* Reserve(size_t n) {
+        if (size_ + n > data_.size()) {
+            data_.resize(std::max(2 * data_.size(), size_ + n));
+        }
+        return data_.data() + size_;
+    }
+
+    void Commit(size_t n) {
+        size_ += n;
+    }
+
+    void Append(const char* bytes, size_t n) {
+        std::memcpy(Reserve(n), bytes, n);
+        Commit(n);
+    }
+
+private:
+    std::vector<char> data_;
+    size_t size_ = 0;
+};
+
+// Escape sequences are precomputed or formatted through lookup tables, so
+// each of these is a bounds check and a memcpy.
+namespace ansi {
+
+// RGB colors are sent as is in ColorMode::kTrueColor and quantized to the
+// palette otherwise.
+void SetForegroundColor(OutputBuffer& out, Color color, ColorMode mode = ColorMode::kPalette);
+
+void SetBackgroundColor(OutputBuffer& out, Color color, ColorMode mode = ColorMode::kPalette);
+
+// Zero-based row and column.
+void MoveCursor(OutputBuffer& out, int y, int x);
+
+void ResetCursor(OutputBuffer& out);
+
+void ClearScreen(OutputBuffer& out);
+
+void PutChar(OutputBuffer& out, uint32_t unicode);
+
+}  // namespace ansi
+
+}  // namespace tui
@@ -10,6 +10,8 @@ struct Char {
     uint32_t unicode = 0;
     Color fg = Color::kDefault;
     Color bg = Color::kDefault;
+
+    bool operator==(const Char& other) const = default;
 };
 
 }  // namepsace tui
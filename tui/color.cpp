@@ -0,0 +1,102 @@
+#include "color.h"
+
+#include <array>
+#include <cassert>
+
+namespace tui {
+
+namespace {
+
+constexpr int kLutBits = 5;
+constexpr int kLutSize = 1 << kLutBits;
+
+constexpr std::array<uint8_t, 6> kCubeLevels = {0, 95, 135, 175, 215, 255};
+
+// The 16 system colors are left to the terminal theme, xterm defaults.
+constexpr std::array<Rgb, 16> kSystemColors = {{
+    {0, 0, 0}, {205, 0, 0}, {0, 205, 0}, {205, 205, 0},
+    {0, 0, 238}, {205, 0, 205}, {0, 205, 205}, {229, 229, 229},
+    {127, 127, 127}, {255, 0, 0}, {0, 255, 0}, {255, 255, 0},
+    {92, 92, 255}, {255, 0, 255}, {0, 255, 255}, {255, 255, 255},
+}};
+
+Rgb PaletteRgb(int index) {
+    assert(index >= 0 && index < 256);
+    if (index < 16) {
+        return kSystemColors[index];
+    }
+    if (index < 232) {
+        index -= 16;
+        return {kCubeLevels[index / 36], kCubeLevels[index / 6 % 6], kCubeLevels[index % 6]};
+    }
+    uint8_t gray = 8 + 10 * (index - 232);
+    return {gray, gray, gray};
+}
+
+class QuantizationTable {
+public:
+    QuantizationTable() {
+        for (int r = 0; r < kLutSize; ++r) {
+            for (int g = 0; g < kLutSize; ++g) {
+                for (int b = 0; b < kLutSize; ++b) {
+                    table_[(r * kLutSize + g) * kLutSize + b] = Nearest(Center(r), Center(g), Center(b));
+                }
+            }
+        }
+    }
+
+    uint8_t operator()(Rgb rgb) const {
+        auto shift = 8 - kLutBits;
+        return table_[((rgb.r >> shift) * kLutSize + (rgb.g >> shift)) * kLutSize + (rgb.b >> shift)];
+    }
+
+private:
+    static int Center(int cell) {
+        return (cell << (8 - kLutBits)) + (1 << (7 - kLutBits));
+    }
+
+    // Only the color cube and the grayscale ramp, as the system colors
+    // depend on the terminal theme.
+    static uint8_t Nearest(int r, int g, int b) {
+        int best = 16;
+        int best_dist = 1 << 30;
+        for (int i = 16; i < 256; ++i) {
+            auto rgb = PaletteRgb(i);
+            auto dr = rgb.r - r;
+            auto dg = rgb.g - g;
+            auto db = rgb.b - b;
+            auto dist = 2 * dr * dr + 4 * dg * dg + 3 * db * db;
+            if (dist < best_dist) {
+                best = i;
+                best_dist = dist;
+            }
+        }
+        return best;
+    }
+
+    std::array<uint8_t, kLutSize * kLutSize * kLutSize> table_;
+};
+
+}  // namespace
+
+Rgb ToRgb(Color color) {
+    if (IsRgb(color)) {
+        auto value = static_cast<int>(color);
+        return {
+            static_cast<uint8_t>(value >> 16),
+            static_cast<uint8_t>(value >> 8),
+            static_cast<uint8_t>(value),
+        };
+    }
+    return PaletteRgb(static_cast<int>(color));
+}
+
+Color ToPalette(Color color) {
+    if (!IsRgb(color)) {
+        return color;
+    }
+    static const QuantizationTable table;
+    return static_cast<Color>(table(ToRgb(color)));
+}
+
+}  // namespace tui
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cstdint>
+
 namespace tui {
 
+// Values 0-255 are xterm palette indices, values with kRgbTag set carry a
+// 24-bit RGB color in the low bytes.
 enum class Color : int {
     kRed = 1,
     kGreen = 2,
@@ -15,5 +19,36 @@ enum class Color : int {
     kDefault = 1000,
 };
 
-}  // namespace tui
+enum class ColorMode {
+    kPalette,
+    kTrueColor,
+};
+
+struct Rgb {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+};
+
+constexpr int kRgbTag = 1 << 24;
 
+constexpr Color MakeRgb(uint8_t r, uint8_t g, uint8_t b) {
+    return static_cast<Color>(kRgbTag | r << 16 | g << 8 | b);
+}
+
+constexpr bool IsRgb(Color color) {
+    return static_cast<int>(color) & kRgbTag;
+}
+
+constexpr bool IsPalette(Color color) {
+    return static_cast<int>(color) >= 0 && static_cast<int>(color) < 256;
+}
+
+// RGB value of a palette or RGB color.
+Rgb ToRgb(Color color);
+
+// Closest palette color of an RGB color through a 32x32x32 lookup table,
+// other colors are returned as is.
+Color ToPalette(Color color);
+
+}  // namespace tui
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+
+namespace tui {
+
+// Bump allocator for temporaries that die within a frame, rewound at once by
+// Reset(). Unlike std::pmr::monotonic_buffer_resource it keeps its memory and
+// grows to fit the largest frame seen, so a steady state frame never reaches
+// the global heap. Not thread safe.
+class FrameArena : public std::pmr::memory_resource {
+public:
+    explicit FrameArena(size_t capacity = kDefaultCapacity)
+        : buffer_(std::make_unique_for_overwrite<std::byte[]>(capacity))
+        , capacity_(capacity)
+    {
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Everything allocated since the last reset must be dead by now.
+    void Reset() {
+        if (demand_ > capacity_) {
+            capacity_ = 2 * demand_;
+            buffer_ = std::make_unique_for_overwrite<std::byte[]>(capacity_);
+        }
+        used_ = 0;
+        demand_ = 0;
+    }
+
+private:
+    static constexpr size_t kDefaultCapacity = 1 << 16;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        // Keeps every pointer into the buffer strictly inside of it.
+        bytes = std::max<size_t>(bytes, 1);
+        demand_ += bytes + alignment;
+        void* ptr = buffer_.get() + used_;
+        auto space = capacity_ - used_;
+        if (std::align(alignment, bytes, ptr, space)) {
+            used_ = capacity_ - space + bytes;
+            return ptr;
+        }
+        // Overflow goes to the heap for this frame only, the next Reset()
+        // makes room for it.
+        return ::operator new(bytes, std::align_val_t(alignment));
+    }
+
+    void do_deallocate(void* ptr, size_t, size_t alignment) override {
+        auto* byte = static_cast<std::byte*>(ptr);
+        if (byte >= buffer_.get() && byte < buffer_.get() + capacity_) {
+            return;
+        }
+        ::operator delete(ptr, std::align_val_t(alignment));
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    std::unique_ptr<std::byte[]> buffer_;
+    size_t capacity_;
+    size_t used_ = 0;
+    // Bytes the frame asked for, alignment included, whether they fit or not.
+    size_t demand_ = 0;
+};
+
+}  // namespace tui
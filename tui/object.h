@@ -2,13 +2,14 @@
 
 #include "char.h"
 
+#include <memory_resource>
 #include <vector>
 
 namespace tui {
 
 class Object {
 public:
-    using Rectangle = std::vector<std::vector<Char>>;
+    using Rectangle = std::pmr::vector<std::pmr::vector<Char>>;
 
     Object(int h, int w) : h_(h), w_(w) {
     }
@@ -21,9 +22,21 @@ public:
         return h_;
     }
 
-    virtual Rectangle BuildChars() const = 0;
+    // The result is allocated from `resource`, which lets callers keep
+    // per-frame rectangles off the heap.
+    virtual Rectangle BuildChars(std::pmr::memory_resource* resource) const = 0;
 
 protected:
+    // Height() rows of Width() empty chars.
+    Rectangle Blank(std::pmr::memory_resource* resource) const {
+        Rectangle result(resource);
+        result.resize(h_);
+        for (auto& row : result) {
+            row.resize(w_);
+        }
+        return result;
+    }
+
     int h_;
     int w_;
 };
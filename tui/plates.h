@@ -16,8 +16,8 @@ public:
     {
     }
 
-    Rectangle BuildChars() const override {
-        Rectangle result(Height(), std::vector<Char>(Width()));
+    Rectangle BuildChars(std::pmr::memory_resource* resource) const override {
+        auto result = Blank(resource);
         for (int i = 0; i < Height(); ++i) {
             result[i][0] = result[i][Width() - 1] = { .unicode = '|', .fg = color_ };
         }
@@ -41,9 +41,9 @@ public:
     {
     }
 
-    Rectangle BuildChars() const override {
+    Rectangle BuildChars(std::pmr::memory_resource* resource) const override {
         assert(Height() == 1 && Width() == text_.size());
-        Rectangle result(Height(), std::vector<Char>(Width()));
+        auto result = Blank(resource);
         for (int i = 0; i < Width(); ++i) {
             result[0][i] = { .unicode = static_cast<uint32_t>(text_[i]), .fg = color_ };
         }
@@ -0,0 +1,58 @@
+#include "presenter.h"
+#include "utils.h"
+
+#include <utility>
+
+namespace tui {
+
+Presenter::Presenter()
+    : worker_([this] { Work(); })
+{
+}
+
+Presenter::~Presenter() {
+    Wait();
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    worker_.join();
+}
+
+void Presenter::Present(OutputBuffer& frame) {
+    {
+        std::unique_lock lock(mutex_);
+        done_.wait(lock, [this] { return !busy_; });
+        std::swap(pending_, frame);
+        busy_ = true;
+    }
+    wake_.notify_one();
+    frame.Clear();
+}
+
+void Presenter::Wait() {
+    std::unique_lock lock(mutex_);
+    done_.wait(lock, [this] { return !busy_; });
+}
+
+void Presenter::Work() {
+    while (true) {
+        {
+            std::unique_lock lock(mutex_);
+            wake_.wait(lock, [this] { return stop_ || busy_; });
+            if (stop_) {
+                return;
+            }
+        }
+        // The buffer is not touched by Present() while busy.
+        utils::WriteTerminal({pending_.Data(), pending_.Size()});
+        {
+            std::lock_guard lock(mutex_);
+            busy_ = false;
+        }
+        done_.notify_all();
+    }
+}
+
+}  // namespace tui
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ansi.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace tui {
+
+// Writes finished frames to the terminal on its own thread, so a slow
+// terminal delays the next frame's output rather than its rendering.
+class Presenter {
+public:
+    Presenter();
+    ~Presenter();
+
+    Presenter(const Presenter&) = delete;
+    Presenter& operator=(const Presenter&) = delete;
+
+    // Queues `frame` for writing once the previous one is out. The buffers
+    // are swapped, `frame` gets back an already written one to reuse.
+    void Present(OutputBuffer& frame);
+
+    // Blocks until everything queued has been written.
+    void Wait();
+
+private:
+    void Work();
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    OutputBuffer pending_;
+    bool busy_ = false;
+    bool stop_ = false;
+
+    // Last, so that it starts once the rest is constructed.
+    std::thread worker_;
+};
+
+}  // namespace tui
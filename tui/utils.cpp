@@ -1,64 +1,75 @@
 #include "utils.h"
+#include "ansi.h"
 
-#include <string.h>
+#include <cassert>
+#include <cstdlib>
+#include <mutex>
+#include <string_view>
 #include <sys/ioctl.h>
 #include <unistd.h>
 
-#include <string>
-
 namespace tui::utils {
 
 namespace {
 
-void PutEsc(int code, char ch) {
-    char buff[16];
-    sprintf(buff, "\033[%i%c", code, ch);
-    write(STDOUT_FILENO, buff, strlen(buff));
-}
+std::mutex terminal_mutex;
 
-void PutDoubleEsc(int code1, int code2, char ch) {
-    char buff[16];
-    sprintf(buff, "\033[%i;%i%c", code1, code2, ch);
-    write(STDOUT_FILENO, buff, strlen(buff));
-}
+// Shared by all the escapes, so only the first one allocates.
+thread_local OutputBuffer esc_buffer;
 
-void PutTrippleEsc(int code1, int code2, int code3, char ch) {
-    char buff[16];
-    sprintf(buff, "\033[%i;%i;%i%c", code1, code2, code3, ch);
-    write(STDOUT_FILENO, buff, strlen(buff));
+template<typename F>
+void PutEsc(F&& encode) {
+    auto& out = esc_buffer;
+    out.Clear();
+    encode(out);
+    WriteTerminal({out.Data(), out.Size()});
 }
 
 }  // namespace
 
 Dims GetScreenDimensions() {
-    winsize w;
-    ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
+    winsize w{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == -1) {
+        return {};
+    }
     return { .x = w.ws_col, .y = w.ws_row };
 }
 
+void WriteTerminal(std::string_view bytes) {
+    std::lock_guard lock(terminal_mutex);
+    while (!bytes.empty()) {
+        auto res = write(STDOUT_FILENO, bytes.data(), bytes.size());
+        assert(res != -1 && "couldn't write to STDOUT_FILENO");
+        bytes.remove_prefix(res);
+    }
+}
+
+ColorMode DetectColorMode() {
+    const char* colorterm = std::getenv("COLORTERM");
+    if (colorterm == nullptr) {
+        return ColorMode::kPalette;
+    }
+    std::string_view value = colorterm;
+    if (value == "truecolor" || value == "24bit") {
+        return ColorMode::kTrueColor;
+    }
+    return ColorMode::kPalette;
+}
+
 void ResetCursor() {
-    PutDoubleEsc(0, 0, 'f');
+    PutEsc([](OutputBuffer& out) { ansi::ResetCursor(out); });
 }
 
 void ClearScreen() {
-    PutEsc(2, 'J');
-    ResetCursor();
+    PutEsc([](OutputBuffer& out) { ansi::ClearScreen(out); });
 }
 
 void SetForegroundColor(Color color) {
-    if (color == Color::kDefault) {
-        PutEsc(static_cast<int>(39), 'm');
-        return;
-    }
-    PutTrippleEsc(38, 5, static_cast<int>(color), 'm');
+    PutEsc([=](OutputBuffer& out) { ansi::SetForegroundColor(out, color); });
 }
 
 void SetBackgroundColor(Color color) {
-    if (color == Color::kDefault) {
-        PutEsc(static_cast<int>(49), 'm');
-        return;
-    }
-    PutTrippleEsc(48, 5, static_cast<int>(color), 'm');
+    PutEsc([=](OutputBuffer& out) { ansi::SetBackgroundColor(out, color); });
 }
 
 }  // namespace tui
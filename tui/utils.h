@@ -2,6 +2,8 @@
 
 #include "color.h"
 
+#include <string_view>
+
 namespace tui::utils {
 
 struct Dims {
@@ -9,8 +11,18 @@ struct Dims {
     int y;
 };
 
+// Zero when stdout is not a terminal.
 Dims GetScreenDimensions();
 
+// Truecolor if advertised through $COLORTERM.
+ColorMode DetectColorMode();
+
+// Writes all of `bytes` to stdout. Frames from the presenter thread, the
+// escapes here and the input reporting modes all go through it, so none of
+// them lands in the middle of another. Writes to stderr, usually the same
+// terminal, bypass it and would also corrupt the view.
+void WriteTerminal(std::string_view bytes);
+
 void ClearScreen();
 
 void SetForegroundColor(Color);
@@ -1,5 +1,7 @@
 #include "view_port.h"
 
+#include <algorithm>
+
 namespace tui {
 
 namespace {
@@ -7,36 +9,85 @@ namespace {
 }  // namespace
 
 void ViewPort::Render(bool do_clear) {
-    caret_ = buff_;
+    out_.Clear();
 
     SetBackgroundColor(Color::kDefault, true);
     SetForegroundColor(Color::kDefault, true);
     if (do_clear) {
         ClearScreen();
-    } else {
-        ResetCursor();
+        front_valid_ = false;
     }
 
-    auto dims = GetDimensions();
-    for (int i = 0; i < chars_.size() && i < dims.y; ++i) {
-        for (int j = 0; j < chars_[0].size() && j < dims.x; ++j) {
-            auto& ch = chars_[i][j];
+    // Clipped to the terminal, if there is one.
+    auto h = screen_.y > 0 ? std::min(h_, screen_.y) : h_;
+    auto w = screen_.x > 0 ? std::min(w_, screen_.x) : w_;
+    for (int i = 0; i < h_; ++i) {
+        for (auto& ch : chars_[i]) {
             if (ch.unicode == 0) {
                 ch.unicode = ' ';
             }
-            Put(chars_[i][j]);
         }
-        Put('\n');
+    }
+
+    if (front_valid_) {
+        RenderDiff(h, w);
+    } else {
+        RenderFull(h, w);
     }
 
     SetBackgroundColor(Color::kDefault, true);
     SetForegroundColor(Color::kDefault, true);
-    auto written = 0;
-    auto to_write = caret_ - buff_;
-    while (written < to_write) {
-        auto res = write(STDOUT_FILENO, buff_ + written, to_write - written);
-        assert(res != -1 && "couldn't write to STDOUT_FILENO");
-        written += res;
+    Flush();
+}
+
+void ViewPort::Flush() {
+    presenter_.Present(out_);
+}
+
+void ViewPort::RenderFull(int h, int w) {
+    ResetCursor();
+    for (int i = 0; i < h; ++i) {
+        for (int j = 0; j < w; ++j) {
+            Put(chars_[i][j]);
+            front_[i * w_ + j] = chars_[i][j];
+        }
+        Put('\n');
+    }
+    front_valid_ = true;
+}
+
+void ViewPort::RenderDiff(int h, int w) {
+    int changed = 0;
+    for (int i = 0; i < h; ++i) {
+        for (int j = 0; j < w; ++j) {
+            changed += !(chars_[i][j] == front_[i * w_ + j]);
+        }
+    }
+    if (changed > kRepaintThreshold * h * w) {
+        RenderFull(h, w);
+        return;
+    }
+
+    // Position of the terminal cursor, unknown until the first move.
+    int cursor_y = -1;
+    int cursor_x = -1;
+    for (int i = 0; i < h; ++i) {
+        for (int j = 0; j < w; ++j) {
+            if (chars_[i][j] == front_[i * w_ + j]) {
+                continue;
+            }
+            if (cursor_y == i && cursor_x < j && j - cursor_x <= kMaxRewrite) {
+                for (; cursor_x < j; ++cursor_x) {
+                    Put(chars_[i][cursor_x]);
+                }
+            } else if (cursor_y != i || cursor_x != j) {
+                MoveCursor(i, j);
+            }
+            Put(chars_[i][j]);
+            front_[i * w_ + j] = chars_[i][j];
+            cursor_y = i;
+            cursor_x = j + 1;
+        }
     }
 }
 
@@ -1,12 +1,12 @@
+#include "ansi.h"
 #include "char.h"
 #include "object.h"
-#include "utf8.h"
+#include "presenter.h"
 #include "utils.h"
 
 #include <cassert>
-#include <cstdlib>
+#include <memory_resource>
 #include <vector>
-#include <stdio.h>
 #include <unistd.h>
 
 namespace tui {
@@ -17,19 +17,41 @@ public:
         : w_(w)
         , h_(h)
         , chars_(h_, std::vector<Char>(w_))
+        , front_(h_ * w_)
+        , screen_(utils::GetScreenDimensions())
     {
-        buff_ = (char*) malloc(20 * w_ * h_);
         assert(w_ > 0 && h_ > 0);
     }
 
-    ~ViewPort() {
-        free(buff_);
+    // Changes the size keeping the storage where it suffices. Everything is
+    // blank afterwards and the next frame is drawn in full.
+    void Resize(int h, int w) {
+        assert(w > 0 && h > 0);
+        h_ = h;
+        w_ = w;
+        chars_.resize(h_);
+        for (auto& row : chars_) {
+            row.assign(w_, Char{});
+        }
+        front_.assign(h_ * w_, Char{});
+        front_valid_ = false;
+    }
+
+    // Size of the terminal, queried once and then only when told it changed.
+    utils::Dims ScreenDimensions() const {
+        return screen_;
+    }
+
+    void RefreshScreenDimensions() {
+        screen_ = utils::GetScreenDimensions();
+        front_valid_ = false;
     }
 
     void Clear() {
-        caret_ = buff_;
+        out_.Clear();
         ClearScreen();
-        write(STDOUT_FILENO, buff_, caret_ - buff_);
+        Flush();
+        front_valid_ = false;
     }
 
     int Width() const {
@@ -40,6 +62,11 @@ public:
         return h_;
     }
 
+    void SetColorMode(ColorMode mode) {
+        color_mode_ = mode;
+        front_valid_ = false;
+    }
+
     void SetChar(int y, int x, const Char& ch) {
         chars_.at(y).at(x) = ch;
     }
@@ -48,11 +75,17 @@ public:
         SetChar(y, x, {.unicode = unicode, .fg = fg, .bg = bg});
     }
 
+    // Where PlaceObject() takes the objects' chars from, e.g. an arena reset
+    // after every frame. They are dropped before it returns.
+    void SetFrameResource(std::pmr::memory_resource* resource) {
+        frame_resource_ = resource;
+    }
+
     void PlaceObject(int y, int x, const Object& object) {
-        SetRectangle(y, x, object.BuildChars());
+        SetRectangle(y, x, object.BuildChars(frame_resource_));
     }
 
-    void SetRectangle(int y, int x, const std::vector<std::vector<tui::Char>>& rect) {
+    void SetRectangle(int y, int x, const Object::Rectangle& rect) {
         for (int i = std::max(0, -y); i < rect.size() && y + i < h_; ++i) {
             for (int j = std::max(0, -x); j < rect[0].size() && x + j < w_; ++j) {
                 if (rect[i][j].unicode == 0) {
@@ -63,33 +96,35 @@ public:
         } 
     }
 
+    // Only the cells which changed since the previous frame are written,
+    // unless most of the screen did. Returns once the frame is encoded, the
+    // write itself happens on the presenter thread. Only one frame can be in
+    // flight: if the previous one is still being written, this blocks until
+    // it is out. A terminal slower than the frame rate therefore still
+    // stalls the caller, one frame later. Frames can't be dropped instead,
+    // because each one only carries the changes since the previous frame.
     void Render(bool do_clear = false);
 
 private:
-    utils::Dims GetDimensions() const {
-        return utils::GetScreenDimensions();
-    }
+    // Share of changed cells above which the whole screen is repainted.
+    static constexpr double kRepaintThreshold = 0.5;
+    // Unchanged runs up to this length are rewritten rather than skipped,
+    // as a cursor move is about as long.
+    static constexpr int kMaxRewrite = 4;
 
-    int PutEsc(int code, char ch) {
-        return sprintf(caret_, "\033[%i%c", code, ch);
-    }
+    void RenderFull(int h, int w);
+    void RenderDiff(int h, int w);
 
-    int PutDoubleEsc(int code1, int code2, char ch) {
-        return sprintf(caret_, "\033[%i;%i%c", code1, code2, ch);
-    }
-
-    int PutTrippleEsc(int code1, int code2, int code3, char ch) {
-        return sprintf(caret_, "\033[%i;%i;%i%c", code1, code2, code3, ch);
+    void ResetCursor() {
+        ansi::ResetCursor(out_);
     }
 
-
-    void ResetCursor() {
-        caret_ += PutDoubleEsc(0, 0, 'f');
+    void MoveCursor(int y, int x) {
+        ansi::MoveCursor(out_, y, x);
     }
 
     void ClearScreen() {
-        caret_ += PutEsc(2, 'J');
-        ResetCursor();
+        ansi::ClearScreen(out_);
     }
 
     void SetForegroundColor(Color color, bool force = false) {
@@ -97,11 +132,7 @@ private:
             return;
         }
         fg_ = color;
-        if (color == Color::kDefault) {
-            caret_ += PutEsc(static_cast<int>(39), 'm');
-            return;
-        }
-        caret_ += PutTrippleEsc(38, 5, static_cast<int>(color), 'm');
+        ansi::SetForegroundColor(out_, color, color_mode_);
     }
 
     void SetBackgroundColor(Color color, bool force = false) {
@@ -109,17 +140,15 @@ private:
             return;
         }
         bg_ = color;
-        if (color == Color::kDefault) {
-            caret_ += PutEsc(static_cast<int>(49), 'm');
-            return;
-        }
-        caret_ += PutTrippleEsc(48, 5, static_cast<int>(color), 'm');
+        ansi::SetBackgroundColor(out_, color, color_mode_);
     }
 
     void Put(uint32_t utf) {
-        caret_ += Utf8Encode(caret_, utf);
+        ansi::PutChar(out_, utf);
     }
 
+    void Flush();
+
     void Put(const Char& ch) {
         SetBackgroundColor(ch.bg);
         SetForegroundColor(ch.fg);
@@ -129,8 +158,15 @@ private:
     int w_;
     int h_;
     std::vector<std::vector<Char>> chars_;
-    char* buff_;
-    char* caret_;
+    // What the terminal currently shows, row-major.
+    std::vector<Char> front_;
+    bool front_valid_ = false;
+    utils::Dims screen_;
+    // Encoded on the calling thread, written out by the presenter.
+    OutputBuffer out_;
+    Presenter presenter_;
+    ColorMode color_mode_ = ColorMode::kPalette;
+    std::pmr::memory_resource* frame_resource_ = std::pmr::get_default_resource();
 
     Color fg_;
     Color bg_;
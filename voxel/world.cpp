@@ -0,0 +1,322 @@
+#include "world.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace voxel {
+
+namespace {
+
+constexpr int kCorners = World::kChunkSize + 1;
+constexpr auto kNoVertex = std::numeric_limits<uint32_t>::max();
+
+using Coord = std::array<int, 3>;
+
+}  // namespace
+
+// Deduplicates lattice points of a chunk into mesh vertices.
+class World::CornerIndex {
+public:
+    CornerIndex(graphics::Mesh& mesh, Coord origin)
+        : mesh_(mesh)
+        , origin_(origin)
+    {
+        indices_.fill(kNoVertex);
+    }
+
+    uint32_t operator()(const Coord& p) {
+        auto local = ((p[1] - origin_[1]) * kCorners + (p[0] - origin_[0])) * kCorners + (p[2] - origin_[2]);
+        assert(local >= 0 && local < static_cast<int>(indices_.size()));
+        auto& index = indices_[local];
+        if (index == kNoVertex) {
+            index = mesh_.AddVertex({
+                static_cast<float>(p[0]),
+                static_cast<float>(p[1]),
+                static_cast<float>(p[2]),
+                1.0,
+            });
+        }
+        return index;
+    }
+
+private:
+    graphics::Mesh& mesh_;
+    Coord origin_;
+    std::array<uint32_t, kCorners * kCorners * kCorners> indices_;
+};
+
+World::World(int size_x, int size_y, int size_z, tui::Color color)
+    : size_x_(size_x)
+    , size_y_(size_y)
+    , size_z_(size_z)
+    , chunks_x_((size_x + kChunkSize - 1) / kChunkSize)
+    , chunks_y_((size_y + kChunkSize - 1) / kChunkSize)
+    , chunks_z_((size_z + kChunkSize - 1) / kChunkSize)
+    , color_(color)
+    , blocks_(size_x * size_y * size_z)
+{
+    assert(size_x_ > 0 && size_y_ > 0 && size_z_ > 0);
+    chunks_.resize(chunks_x_ * chunks_y_ * chunks_z_);
+    for (int cy = 0; cy < chunks_y_; ++cy) {
+        for (int cx = 0; cx < chunks_x_; ++cx) {
+            for (int cz = 0; cz < chunks_z_; ++cz) {
+                auto& chunk = chunks_[ChunkIndex(cx, cy, cz)];
+                chunk.x = cx * kChunkSize;
+                chunk.y = cy * kChunkSize;
+                chunk.z = cz * kChunkSize;
+            }
+        }
+    }
+}
+
+void World::Set(int x, int y, int z, bool solid) {
+    if (!Contains(x, y, z) || blocks_[Index(x, y, z)] == solid) {
+        return;
+    }
+    blocks_[Index(x, y, z)] = solid;
+
+    // Faces and edges of a chunk depend on the blocks right next to it.
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            for (int dz = -1; dz <= 1; ++dz) {
+                if (Contains(x + dx, y + dy, z + dz)) {
+                    chunks_[ChunkIndex((x + dx) / kChunkSize, (y + dy) / kChunkSize, (z + dz) / kChunkSize)].dirty = true;
+                }
+            }
+        }
+    }
+}
+
+std::optional<World::Hit> World::Raycast(math::Vec3 origin, math::Vec3 direction, float max_distance) const {
+    auto len = direction.Len();
+    if (len < 1e-9) {
+        return std::nullopt;
+    }
+    direction = direction * (1 / len);
+
+    std::array<float, 3> pos = {origin.x, origin.y, origin.z};
+    std::array<float, 3> dir = {direction.x, direction.y, direction.z};
+    Coord cell;
+    Coord step;
+    // Distance along the ray to the next cell boundary and between two
+    // boundaries for every axis.
+    std::array<float, 3> next;
+    std::array<float, 3> delta;
+    for (int i = 0; i < 3; ++i) {
+        cell[i] = static_cast<int>(std::floor(pos[i]));
+        if (dir[i] > 0) {
+            step[i] = 1;
+            delta[i] = 1 / dir[i];
+            next[i] = (cell[i] + 1 - pos[i]) * delta[i];
+        } else if (dir[i] < 0) {
+            step[i] = -1;
+            delta[i] = -1 / dir[i];
+            next[i] = (pos[i] - cell[i]) * delta[i];
+        } else {
+            step[i] = 0;
+            delta[i] = next[i] = std::numeric_limits<float>::infinity();
+        }
+    }
+
+    Coord normal = {0, 0, 0};
+    float distance = 0;
+    while (distance <= max_distance) {
+        if (Get(cell[0], cell[1], cell[2])) {
+            return Hit{
+                .x = cell[0], .y = cell[1], .z = cell[2],
+                .nx = normal[0], .ny = normal[1], .nz = normal[2],
+            };
+        }
+        int axis = 0;
+        if (next[1] < next[axis]) {
+            axis = 1;
+        }
+        if (next[2] < next[axis]) {
+            axis = 2;
+        }
+        // Nothing left to hit once the ray is outside and moving away.
+        if ((step[axis] > 0 && cell[axis] >= std::array{size_x_, size_y_, size_z_}[axis])
+                || (step[axis] < 0 && cell[axis] < 0)) {
+            break;
+        }
+        distance = next[axis];
+        next[axis] += delta[axis];
+        cell[axis] += step[axis];
+        normal = {0, 0, 0};
+        normal[axis] = -step[axis];
+    }
+    return std::nullopt;
+}
+
+math::Box World::ChunkBounds(int chunk) const {
+    const auto& target = chunks_.at(chunk);
+    return {
+        .min = {static_cast<float>(target.x), static_cast<float>(target.y), static_cast<float>(target.z)},
+        .max = {
+            static_cast<float>(std::min(target.x + kChunkSize, size_x_)),
+            static_cast<float>(std::min(target.y + kChunkSize, size_y_)),
+            static_cast<float>(std::min(target.z + kChunkSize, size_z_)),
+        },
+    };
+}
+
+std::pmr::vector<int> World::ChunksFrontToBack(math::Vec3 eye, std::pmr::memory_resource* resource) const {
+    std::pmr::vector<std::pair<float, int>> distances(resource);
+    distances.reserve(chunks_.size());
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        const auto& chunk = chunks_[i];
+        math::Vec3 center{
+            chunk.x + kChunkSize / 2.0f - eye.x,
+            chunk.y + kChunkSize / 2.0f - eye.y,
+            chunk.z + kChunkSize / 2.0f - eye.z,
+        };
+        distances.push_back({center.x * center.x + center.y * center.y + center.z * center.z, static_cast<int>(i)});
+    }
+    std::sort(distances.begin(), distances.end());
+
+    std::pmr::vector<int> order(resource);
+    order.reserve(distances.size());
+    for (const auto& [distance, chunk] : distances) {
+        order.push_back(chunk);
+    }
+    return order;
+}
+
+const graphics::Mesh& World::ChunkMesh(int chunk) {
+    auto& target = chunks_.at(chunk);
+    if (target.dirty) {
+        target.mesh.Clear();
+        CornerIndex corner(target.mesh, {target.x, target.y, target.z});
+        BuildFaces(target, corner);
+        BuildEdges(target, corner);
+        target.dirty = false;
+    }
+    return target.mesh;
+}
+
+void World::BuildFaces(Chunk& chunk, CornerIndex& corner) {
+    Coord origin = {chunk.x, chunk.y, chunk.z};
+    Coord size = {size_x_, size_y_, size_z_};
+    std::array<bool, kChunkSize * kChunkSize> mask;
+
+    for (int d = 0; d < 3; ++d) {
+        int u = (d + 1) % 3;
+        int v = (d + 2) % 3;
+        int len_u = std::min(kChunkSize, size[u] - origin[u]);
+        int len_v = std::min(kChunkSize, size[v] - origin[v]);
+        int end_d = std::min(origin[d] + kChunkSize, size[d]);
+
+        for (int side : {-1, 1}) {
+            for (int k = origin[d]; k < end_d; ++k) {
+                for (int iu = 0; iu < len_u; ++iu) {
+                    for (int iv = 0; iv < len_v; ++iv) {
+                        Coord p;
+                        p[d] = k;
+                        p[u] = origin[u] + iu;
+                        p[v] = origin[v] + iv;
+                        auto q = p;
+                        q[d] += side;
+                        mask[iu * kChunkSize + iv] = Get(p[0], p[1], p[2]) && !Get(q[0], q[1], q[2]);
+                    }
+                }
+
+                // Greedily grow each visible face along u, then along v.
+                for (int iu = 0; iu < len_u; ++iu) {
+                    for (int iv = 0; iv < len_v; ++iv) {
+                        if (!mask[iu * kChunkSize + iv]) {
+                            continue;
+                        }
+                        int w = 1;
+                        while (iu + w < len_u && mask[(iu + w) * kChunkSize + iv]) {
+                            ++w;
+                        }
+                        int h = 1;
+                        for (; iv + h < len_v; ++h) {
+                            bool full = true;
+                            for (int t = 0; t < w && full; ++t) {
+                                full = mask[(iu + t) * kChunkSize + iv + h];
+                            }
+                            if (!full) {
+                                break;
+                            }
+                        }
+                        for (int t = 0; t < w; ++t) {
+                            for (int s = 0; s < h; ++s) {
+                                mask[(iu + t) * kChunkSize + iv + s] = false;
+                            }
+                        }
+
+                        auto at = [&](int du, int dv) {
+                            Coord p;
+                            p[d] = k + (side > 0 ? 1 : 0);
+                            p[u] = origin[u] + iu + du;
+                            p[v] = origin[v] + iv + dv;
+                            return corner(p);
+                        };
+                        chunk.mesh.AddFace({at(0, 0), at(w, 0), at(w, h), at(0, h)},
+                            color_, tui::Color::kDefault, {static_cast<float>(w), static_cast<float>(h)});
+                    }
+                }
+            }
+        }
+    }
+}
+
+void World::BuildEdges(Chunk& chunk, CornerIndex& corner) {
+    Coord origin = {chunk.x, chunk.y, chunk.z};
+    Coord size = {size_x_, size_y_, size_z_};
+
+    for (int a = 0; a < 3; ++a) {
+        int b = (a + 1) % 3;
+        int c = (a + 2) % 3;
+        // Lattice lines on the far border of the world belong to the last chunk.
+        auto last = [&](int axis) {
+            return origin[axis] + kChunkSize >= size[axis] ? size[axis] : origin[axis] + kChunkSize - 1;
+        };
+        int end_a = std::min(origin[a] + kChunkSize, size[a]);
+
+        for (int lb = origin[b]; lb <= last(b); ++lb) {
+            for (int lc = origin[c]; lc <= last(c); ++lc) {
+                int run = -1;
+                for (int pa = origin[a]; pa <= end_a; ++pa) {
+                    bool crease = false;
+                    if (pa < end_a) {
+                        auto solid = [&](int db, int dc) {
+                            Coord p;
+                            p[a] = pa;
+                            p[b] = lb - 1 + db;
+                            p[c] = lc - 1 + dc;
+                            return Get(p[0], p[1], p[2]);
+                        };
+                        bool s00 = solid(0, 0);
+                        bool s01 = solid(0, 1);
+                        bool s10 = solid(1, 0);
+                        bool s11 = solid(1, 1);
+                        int count = s00 + s01 + s10 + s11;
+                        // Convex and concave edges, the ones inside a flat
+                        // surface or fully inside the volume are skipped.
+                        crease = count == 1 || count == 3 || (count == 2 && (s00 == s11));
+                    }
+                    if (crease && run == -1) {
+                        run = pa;
+                    } else if (!crease && run != -1) {
+                        Coord from;
+                        from[a] = run;
+                        from[b] = lb;
+                        from[c] = lc;
+                        auto to = from;
+                        to[a] = pa;
+                        chunk.mesh.AddEdge(corner(from), corner(to), tui::Color::kWhite);
+                        run = -1;
+                    }
+                }
+            }
+        }
+    }
+}
+
+}  // namespace voxel
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "graphics/mesh.h"
+#include "math/common.h"
+#include "math/frustum.h"
+#include "tui/color.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+namespace voxel {
+
+// Block grid split into cubic chunks, each with a cached mesh in block units.
+// Faces between two solid blocks are never meshed and coplanar faces are
+// merged into rectangles whose extent is stored in `Mesh::Face::extent`.
+class World {
+public:
+    static constexpr int kChunkSize = 8;
+
+    struct Hit {
+        int x;
+        int y;
+        int z;
+        // Outward normal of the face the ray entered the block through,
+        // zero if the ray starts inside the block.
+        int nx;
+        int ny;
+        int nz;
+    };
+
+    World(int size_x, int size_y, int size_z, tui::Color color);
+
+    int SizeX() const {
+        return size_x_;
+    }
+
+    int SizeY() const {
+        return size_y_;
+    }
+
+    int SizeZ() const {
+        return size_z_;
+    }
+
+    // Blocks outside of the world are empty.
+    bool Get(int x, int y, int z) const {
+        if (!Contains(x, y, z)) {
+            return false;
+        }
+        return blocks_[Index(x, y, z)];
+    }
+
+    // Only the chunks whose meshes can see the block are rebuilt.
+    void Set(int x, int y, int z, bool solid);
+
+    // Walks the blocks pierced by the ray in block units and returns the
+    // first solid one within `max_distance` along `direction`.
+    std::optional<Hit> Raycast(math::Vec3 origin, math::Vec3 direction, float max_distance) const;
+
+    int ChunkCount() const {
+        return chunks_.size();
+    }
+
+    // Bounds of the chunk in block units.
+    math::Box ChunkBounds(int chunk) const;
+
+    // Chunk indices sorted by the distance from `eye` in block units to the
+    // chunk centers, so that drawing in this order lets near blocks occlude.
+    // The result and its scratch space are allocated from `resource`.
+    std::pmr::vector<int> ChunksFrontToBack(math::Vec3 eye, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+
+    // Rebuilds the mesh if the chunk was modified since the last call.
+    const graphics::Mesh& ChunkMesh(int chunk);
+
+private:
+    struct Chunk {
+        int x;
+        int y;
+        int z;
+        bool dirty = true;
+        graphics::Mesh mesh;
+    };
+
+    bool Contains(int x, int y, int z) const {
+        return x >= 0 && x < size_x_ && y >= 0 && y < size_y_ && z >= 0 && z < size_z_;
+    }
+
+    int Index(int x, int y, int z) const {
+        return (y * size_x_ + x) * size_z_ + z;
+    }
+
+    int ChunkIndex(int cx, int cy, int cz) const {
+        return (cy * chunks_x_ + cx) * chunks_z_ + cz;
+    }
+
+    class CornerIndex;
+
+    void BuildFaces(Chunk& chunk, CornerIndex& corner);
+    void BuildEdges(Chunk& chunk, CornerIndex& corner);
+
+    int size_x_;
+    int size_y_;
+    int size_z_;
+    int chunks_x_;
+    int chunks_y_;
+    int chunks_z_;
+    tui::Color color_;
+
+    std::vector<uint8_t> blocks_;
+    std::vector<Chunk> chunks_;
+};
+
+}  // namespace voxel